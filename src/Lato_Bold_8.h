@@ -7,7 +7,7 @@
 
 // Created by http://oleddisplay.squix.ch/ Consider a donation
 // In case of problems make sure that you are using the font file with the correct version!
-const char Lato_Bold_8[] PROGMEM = {
+const uint8_t Lato_Bold_8[] PROGMEM = {
 	0x08, // Width: 8
 	0x0A, // Height: 10
 	0x20, // First Char: 32
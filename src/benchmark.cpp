@@ -0,0 +1,196 @@
+#include "benchmark.h"
+#include "oled_display.h"
+#include "input.h"
+#include "stage_timing.h"
+#include "exposure.h"
+#include "light_sensor.h"
+
+extern OledDisplay oledDisplay;
+extern settings_t settings;
+extern TaskHandle_t lightSensorTask;
+extern LightSensor lightSensor;
+extern int8_t propertyChangeIndex;
+
+uint32_t lightSensorUpdate();
+void handleButtonEvent(const inputEvent_t &event);
+void settingsChanged();
+
+// Times body over the iterations, after one untimed warm-up run
+template <class T> static benchmarkResult_t benchmarkMeasure(uint32_t iterations, T body) {
+    benchmarkResult_t result = {iterations, 0, UINT32_MAX, 0};
+    uint64_t total = 0;
+
+    body();
+    for (uint32_t i = 0; i < iterations; i++) {
+        const uint32_t start = ESP.getCycleCount();
+        body();
+        const uint32_t cycles = ESP.getCycleCount() - start;
+
+        total += cycles;
+        result.min = (cycles < result.min) ? cycles : result.min;
+        result.max = (cycles > result.max) ? cycles : result.max;
+    }
+    result.mean = total / iterations;
+
+    return result;
+}
+
+void Benchmark::report(const char *name, const benchmarkResult_t &result) {
+    char line[128];
+
+    snprintf(line, sizeof(line), "bench name=%s iterations=%lu mean=%lu min=%lu max=%lu unit=cycles\n", name,
+             (unsigned long)result.iterations, (unsigned long)result.mean, (unsigned long)result.min,
+             (unsigned long)result.max);
+    Serial.print(line);
+}
+
+// One lightSensorTaskHandler iteration without the wait for the next period
+void Benchmark::sensorUpdate() {
+    report("sensor_update", benchmarkMeasure(BENCHMARK_SENSOR_ITERATIONS, [] { lightSensorUpdate(); }));
+}
+
+// Counts of the last reading to the exposure result, float lux and log2f against fixed point
+void Benchmark::evCompute() {
+    static exposureResult_t result;
+    const uint16_t counts = lightSensor.getCounts();
+    const uint8_t gain = lightSensor.getGain();
+    const uint8_t integrationTime = lightSensor.getIntegrationTime();
+
+    report("ev_float", benchmarkMeasure(BENCHMARK_ITERATIONS, [&] {
+        exposureSolve(lightSensor.getLuxForCounts(counts), settings, &result);
+    }));
+    report("ev_fixed", benchmarkMeasure(BENCHMARK_ITERATIONS, [&] {
+        exposureSolveFixed(LightSensor::countsToLog2Lux(counts, gain, integrationTime), settings, &result);
+    }));
+}
+
+// Aperture of every preset from one solved sample, the batch pass on its own
+void Benchmark::presetSolve() {
+    static int16_t apertureSteps[CAMERA_PRESET_COUNT];
+    exposureResult_t result;
+
+    exposureSolve(lightSensor.getLux(), settings, &result);
+    report("preset_solve", benchmarkMeasure(BENCHMARK_ITERATIONS, [&result] {
+        exposureSolvePresets(result, settings.type, cameraPresets.get(), apertureSteps);
+    }));
+}
+
+// Latest measurement as the given page would show it
+void Benchmark::prepareView(uint8_t page) {
+    oledDisplay.setPage(page);
+    measurementSnapshot.read(&oledDisplay._measurement);
+    measurementResolve(&oledDisplay._measurement, settings, cameraPresets.get());
+    oledDisplay.buildView(&oledDisplay._view);
+}
+
+/*
+  Drawing into the frame buffer, the flush is timed as a stage of its own.
+  Runs through the font renderer first, then the glyph atlas, and checks
+  that both drew the same pixels
+*/
+void Benchmark::renderPage(const char *name, uint8_t page, void (OledDisplay::*render)()) {
+    static uint8_t fontFrame[OLED_BUFFER_SIZE];
+    char caseName[32];
+    char line[64];
+
+    prepareView(page);
+
+    oledDisplay._atlas.setEnabled(false);
+    snprintf(caseName, sizeof(caseName), "%s_font", name);
+    report(caseName, benchmarkMeasure(BENCHMARK_RENDER_ITERATIONS, [render] { (oledDisplay.*render)(); }));
+    memcpy(fontFrame, oledDisplay._display->buffer, OLED_BUFFER_SIZE);
+
+    oledDisplay._atlas.setEnabled(true);
+    report(name, benchmarkMeasure(BENCHMARK_RENDER_ITERATIONS, [render] { (oledDisplay.*render)(); }));
+
+    snprintf(line, sizeof(line), "bench_check name=atlas_%s identical=%d\n", name,
+             memcmp(fontFrame, oledDisplay._display->buffer, OLED_BUFFER_SIZE) == 0);
+    Serial.print(line);
+}
+
+// Forced redraw with nothing visible changed, what steady light costs per sample
+void Benchmark::pageUnchanged() {
+    prepareView(OLED_PAGE_APERTURE);
+    report("page_unchanged", benchmarkMeasure(BENCHMARK_ITERATIONS, [] {
+        oledDisplay.forceDisplay();
+        oledDisplay.page();
+    }));
+}
+
+void Benchmark::renderWidgetEv() {
+    report("render_widget_ev", benchmarkMeasure(BENCHMARK_ITERATIONS, [] { oledDisplay.renderWidgetEv(); }));
+}
+
+/*
+  Up and Down presses moving the selected property. Settings are put back
+  afterwards, so the journal sees no change
+*/
+void Benchmark::buttonEvent() {
+    const settings_t savedSettings = settings;
+    const int8_t savedPropertyChangeIndex = propertyChangeIndex;
+    uint32_t presses = 0;
+
+    const benchmarkResult_t result = benchmarkMeasure(BENCHMARK_ITERATIONS, [&presses] {
+        const inputEvent_t event = {INPUT_EVENT_BUTTON, (presses++ % 2) ? BUTTON_DOWN : BUTTON_UP, INPUT_PRESS_SHORT, millis()};
+        handleButtonEvent(event);
+    });
+
+    settings = savedSettings;
+    propertyChangeIndex = savedPropertyChangeIndex;
+    settingsChanged();
+    report("button_event", result);
+}
+
+// Long press detection pass with every button released
+void Benchmark::inputPoll() {
+    report("input_poll", benchmarkMeasure(BENCHMARK_ITERATIONS, [] { ::inputPoll(); }));
+}
+
+// Cost of one stage timing sample, on a histogram of its own
+void Benchmark::timingRecord() {
+    static StageTiming timing;
+
+    report("timing_record", benchmarkMeasure(BENCHMARK_ITERATIONS, [] {
+        timing.stop(TIMING_STAGE_EV_COMPUTE, StageTiming::start());
+    }));
+}
+
+void Benchmark::run() {
+#ifndef NATIVE_BUILD
+    char line[64];
+#endif
+
+    const uint8_t page = oledDisplay.getPage();
+
+    // The sensor task would race the benchmark for the sensor and the display buffer
+    vTaskSuspend(lightSensorTask);
+
+#ifdef NATIVE_BUILD
+    Serial.print("bench_begin target=native\n");
+#else
+    snprintf(line, sizeof(line), "bench_begin target=esp32 cpu_mhz=%lu\n", (unsigned long)getCpuFrequencyMhz());
+    Serial.print(line);
+#endif
+
+    sensorUpdate();
+    evCompute();
+    presetSolve();
+    renderPage("render_aperture", OLED_PAGE_APERTURE, &OledDisplay::renderPageAperture);
+    renderPage("render_shutter", OLED_PAGE_SHUTTER, &OledDisplay::renderPageShutter);
+    renderPage("render_iso", OLED_PAGE_ISO, &OledDisplay::renderPageIso);
+    renderPage("render_nd", OLED_PAGE_ND, &OledDisplay::renderPageNd);
+    renderPage("render_flicker", OLED_PAGE_FLICKER, &OledDisplay::renderPageFlicker);
+    renderPage("render_presets", OLED_PAGE_PRESETS, &OledDisplay::renderPagePresets);
+    renderPage("render_memory", OLED_PAGE_MEMORY, &OledDisplay::renderPageMemory);
+    renderWidgetEv();
+    pageUnchanged();
+    buttonEvent();
+    inputPoll();
+    timingRecord();
+
+    Serial.print("bench_end\n");
+
+    vTaskResume(lightSensorTask);
+    oledDisplay.setPage(page);
+    oledDisplay.forceDisplay();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "Arduino.h"
+#include "oled_display.h"
+
+// Per case, the sensor read is a real I2C transaction on the target
+#define BENCHMARK_SENSOR_ITERATIONS 32
+#define BENCHMARK_RENDER_ITERATIONS 200
+#define BENCHMARK_ITERATIONS 1000
+
+typedef struct benchmarkResult_s {
+    uint32_t iterations;
+    uint32_t mean;
+    uint32_t min;
+    uint32_t max;
+} benchmarkResult_t;
+
+/*
+  Cycle counts of the sensor task step, page rendering and button handling,
+  the same code on the target (ESP.getCycleCount) and the native host build.
+  One line per case, key=value, between "bench_begin" and "bench_end":
+    bench name=render_aperture iterations=200 mean=812345 min=801234 max=901234 unit=cycles
+  and "bench_check" lines for the checks done along the way
+  Run it with a "b" line over Serial or .pio/build/native/program bench.
+  The sensor task is suspended while it runs
+*/
+class Benchmark {
+    public:
+        void run();
+    private:
+        void report(const char *name, const benchmarkResult_t &result);
+        void sensorUpdate();
+        void evCompute();
+        void presetSolve();
+        void prepareView(uint8_t page);
+        void renderPage(const char *name, uint8_t page, void (OledDisplay::*render)());
+        void renderWidgetEv();
+        void pageUnchanged();
+        void buttonEvent();
+        void inputPoll();
+        void timingRecord();
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "boot_timing.h"
+
+static const char *const BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = {
+    "sensor_started",
+    "settings_loaded",
+    "storage_ready",
+    "display_ready",
+    "task_started",
+    "first_ev",
+    "first_frame"
+};
+
+void BootTiming::mark(uint8_t phase) {
+    if (isReached(phase)) {
+        return;
+    }
+    _at[phase] = micros();
+    _reached.fetch_or(1 << phase, std::memory_order_release);
+}
+
+void BootTiming::print() {
+    char line[64];
+
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        if (isReached(phase)) {
+            snprintf(line, sizeof(line), "boot phase=%s at_us=%lu\n", BOOT_PHASE_NAMES[phase], (unsigned long)_at[phase]);
+            Serial.print(line);
+        }
+    }
+    snprintf(line, sizeof(line), "boot time_to_first_ev_ms=%lu\n", (unsigned long)(getMicros(BOOT_PHASE_FIRST_EV) / 1000));
+    Serial.print(line);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include "Arduino.h"
+#include <atomic>
+
+// In the order setup() gets through them
+enum bootPhase_e {
+    // VEML7700 configured, the first integration is running
+    BOOT_PHASE_SENSOR_STARTED = 0,
+    BOOT_PHASE_SETTINGS_LOADED,
+    // Measurement log, presets and calibration
+    BOOT_PHASE_STORAGE_READY,
+    BOOT_PHASE_DISPLAY_READY,
+    BOOT_PHASE_TASK_STARTED,
+    // Sensor task published the first measurement
+    BOOT_PHASE_FIRST_EV,
+    // UI loop drew it
+    BOOT_PHASE_FIRST_FRAME,
+    BOOT_PHASE_COUNT
+};
+
+/*
+  Timestamps of the boot phases in microseconds since the application
+  started, the bootloaders before it are not counted. Only the first mark
+  of a phase is kept, so the hot paths can mark unconditionally. Each
+  phase is marked from one core only
+*/
+class BootTiming {
+    public:
+        void mark(uint8_t phase);
+        bool isReached(uint8_t phase) { return _reached.load(std::memory_order_acquire) & (1 << phase); }
+        uint32_t getMicros(uint8_t phase) { return isReached(phase) ? _at[phase] : 0; }
+        // One "boot phase=..." line per reached phase and the time to the first EV
+        void print();
+    private:
+        uint32_t _at[BOOT_PHASE_COUNT] = {};
+        std::atomic<uint8_t> _reached{0};
+};
+
+extern BootTiming bootTiming;
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#ifndef BYTE_ORDER_H
+#define BYTE_ORDER_H
+
+#include "Arduino.h"
+
+/*
+  Little endian field packing for the on-flash and on-wire formats, keeps
+  them independent of struct layout and host endianness
+*/
+static inline void putLe(uint8_t *dst, uint32_t value, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        dst[i] = value >> (8 * i);
+    }
+}
+
+static inline uint32_t getLe(const uint8_t *src, uint8_t size) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        value |= (uint32_t)src[i] << (8 * i);
+    }
+    return value;
+}
+
+#endif
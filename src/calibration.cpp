@@ -0,0 +1,212 @@
+#include "calibration.h"
+#include "exposure.h"
+#include "light_sensor.h"
+#include <Preferences.h>
+
+static const char *const CALIBRATION_TYPE_NAMES[LIGHT_METER_TYPE_COUNT] = {
+    "incident",
+    "reflected"
+};
+
+// Log2 lux step between table entries, in fixed point fraction bits
+#define CALIBRATION_LUT_SHIFT (EXPOSURE_FIXED_BITS - CALIBRATION_LUT_STEP_BITS)
+
+static int32_t calibrationPointLog2Lux(const calibrationPoint_t &point) {
+    return LightSensor::countsToLog2Lux(point.counts, point.gain, point.integrationTime);
+}
+
+int32_t Calibration::getPointCorrection(const calibrationPoint_t &point) {
+    const int32_t reference = (int32_t)point.referenceEvHundredths * EXPOSURE_FIXED_ONE / 100;
+
+    return reference - exposureNominalEvFixed(calibrationPointLog2Lux(point), point.type);
+}
+
+bool Calibration::begin() {
+    Preferences preferences;
+    uint8_t data[1 + sizeof(_points)];
+    size_t size = 0;
+
+    // Read only open fails until the first point created the namespace
+    if (preferences.begin(CALIBRATION_NAMESPACE, true)) {
+        size = preferences.getBytes(CALIBRATION_KEY, data, sizeof(data));
+        preferences.end();
+    }
+
+    // NVS checks its entries on its own, only the layout is left to check
+    _count = 0;
+    if (size > 0 && data[0] == CALIBRATION_VERSION && (size - 1) % sizeof(calibrationPoint_t) == 0) {
+        _count = (size - 1) / sizeof(calibrationPoint_t);
+        memcpy(_points, data + 1, size - 1);
+    }
+
+    build();
+    return _count > 0;
+}
+
+bool Calibration::save() {
+    Preferences preferences;
+    uint8_t data[1 + sizeof(_points)];
+    const size_t size = 1 + _count * sizeof(calibrationPoint_t);
+
+    data[0] = CALIBRATION_VERSION;
+    memcpy(data + 1, _points, size - 1);
+
+    if (!preferences.begin(CALIBRATION_NAMESPACE, false)) {
+        return false;
+    }
+    const bool written = preferences.putBytes(CALIBRATION_KEY, data, size) == size;
+    preferences.end();
+    return written;
+}
+
+/*
+  Runs on the UI loop only. The sensor task may still be reading the
+  active table, so the spare one is filled and then swapped in. A lookup
+  that started on the spare one before the last swap is at most two loads
+  away from done, it is waited out before the spare one is written
+*/
+void Calibration::build() {
+    const uint8_t spare = _active.load(std::memory_order_relaxed) ^ 1;
+    calibrationLut_t *lut = &_luts[spare];
+
+    while (_readers[spare].load() != 0) {
+    }
+
+    int32_t position[CALIBRATION_POINT_MAX];
+    int32_t correction[CALIBRATION_POINT_MAX];
+
+    for (uint8_t type = 0; type < LIGHT_METER_TYPE_COUNT; type++) {
+        uint8_t count = 0;
+
+        // Points of the type sorted by log2 lux, there are few of them
+        for (uint8_t i = 0; i < _count; i++) {
+            if (_points[i].type != type) {
+                continue;
+            }
+
+            const int32_t log2Lux = calibrationPointLog2Lux(_points[i]);
+            uint8_t j = count++;
+            for (; j > 0 && position[j - 1] > log2Lux; j--) {
+                position[j] = position[j - 1];
+                correction[j] = correction[j - 1];
+            }
+            position[j] = log2Lux;
+            correction[j] = getPointCorrection(_points[i]);
+        }
+
+        uint8_t segment = 0;
+        for (uint16_t i = 0; i < CALIBRATION_LUT_COUNT; i++) {
+            const int32_t log2Lux = CALIBRATION_LUT_MIN_STOPS * EXPOSURE_FIXED_ONE + ((int32_t)i << CALIBRATION_LUT_SHIFT);
+            int32_t value = 0;
+
+            if (count > 0 && log2Lux <= position[0]) {
+                value = correction[0];
+            } else if (count > 0 && log2Lux >= position[count - 1]) {
+                value = correction[count - 1];
+            } else if (count > 0) {
+                // Table entries only move up, so does the segment
+                while (log2Lux >= position[segment + 1]) {
+                    segment++;
+                }
+                value = correction[segment] + (int64_t)(correction[segment + 1] - correction[segment]) *
+                                              (log2Lux - position[segment]) / (position[segment + 1] - position[segment]);
+            }
+
+            // Rounded to the table precision
+            const int32_t shift = EXPOSURE_FIXED_BITS - CALIBRATION_LUT_FRACTION_BITS;
+            lut->correction[type][i] = (int16_t)((value + (1 << (shift - 1))) >> shift);
+        }
+    }
+
+    _active.store(spare);
+}
+
+int32_t Calibration::getCorrection(uint8_t type, int32_t log2Lux) {
+    const int32_t position = constrain(log2Lux - CALIBRATION_LUT_MIN_STOPS * EXPOSURE_FIXED_ONE, 0,
+                                       (int32_t)(CALIBRATION_LUT_COUNT - 1) << CALIBRATION_LUT_SHIFT);
+    const int32_t index = position >> CALIBRATION_LUT_SHIFT;
+    const int32_t fraction = position & ((1 << CALIBRATION_LUT_SHIFT) - 1);
+    uint8_t active = _active.load();
+
+    // Pinned before it is read, after a swap in between the pin moves to the new table
+    _readers[active].fetch_add(1);
+    while (_active.load() != active) {
+        _readers[active].fetch_sub(1);
+        active = _active.load();
+        _readers[active].fetch_add(1);
+    }
+
+    const int16_t *table = _luts[active].correction[(type < LIGHT_METER_TYPE_COUNT) ? type : 0];
+    const int32_t low = table[index];
+    const int32_t high = table[(index < CALIBRATION_LUT_COUNT - 1) ? index + 1 : index];
+    _readers[active].fetch_sub(1, std::memory_order_release);
+
+    // Table fraction bits plus the step shift, brought down to EXPOSURE_FIXED_BITS
+    return ((low << CALIBRATION_LUT_SHIFT) + (high - low) * fraction) >>
+           (CALIBRATION_LUT_SHIFT - (EXPOSURE_FIXED_BITS - CALIBRATION_LUT_FRACTION_BITS));
+}
+
+bool Calibration::addPoint(const calibrationPoint_t &point) {
+    const int32_t correction = getPointCorrection(point);
+
+    // Saturated or dark readings say nothing about the response
+    if (point.type >= LIGHT_METER_TYPE_COUNT || point.counts == 0 || point.counts >= LIGHT_SENSOR_COUNTS_SATURATED ||
+        abs(correction) > CALIBRATION_CORRECTION_MAX_STOPS * EXPOSURE_FIXED_ONE) {
+        return false;
+    }
+
+    const int32_t log2Lux = calibrationPointLog2Lux(point);
+    uint8_t slot = _count;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_points[i].type == point.type && abs(calibrationPointLog2Lux(_points[i]) - log2Lux) < EXPOSURE_FIXED(CALIBRATION_MERGE_STOPS)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == CALIBRATION_POINT_MAX) {
+        return false;
+    }
+
+    _points[slot] = point;
+    if (slot == _count) {
+        _count++;
+    }
+
+    build();
+    return save();
+}
+
+bool Calibration::clear() {
+    Preferences preferences;
+
+    _count = 0;
+    build();
+
+    if (!preferences.begin(CALIBRATION_NAMESPACE, false)) {
+        return false;
+    }
+    // Fails when there was nothing stored, which is cleared as well
+    preferences.remove(CALIBRATION_KEY);
+    preferences.end();
+    return true;
+}
+
+void Calibration::print() {
+    char line[160];
+    uint8_t perType[LIGHT_METER_TYPE_COUNT] = {};
+
+    for (uint8_t i = 0; i < _count; i++) {
+        const calibrationPoint_t &point = _points[i];
+        const uint8_t type = (point.type < LIGHT_METER_TYPE_COUNT) ? point.type : 0;
+
+        perType[type]++;
+        snprintf(line, sizeof(line),
+                 "calibration point=%u type=%s gain=%u integration_time=%u counts=%u reference_ev=%.2f correction=%.2f\n", i,
+                 CALIBRATION_TYPE_NAMES[type], point.gain, point.integrationTime, point.counts,
+                 point.referenceEvHundredths / 100.0f, (float)getPointCorrection(point) / EXPOSURE_FIXED_ONE);
+        Serial.print(line);
+    }
+    snprintf(line, sizeof(line), "calibration points=%u incident=%u reflected=%u lut_entries=%u\n", _count,
+             perType[LIGHT_METER_TYPE_INCIDENT], perType[LIGHT_METER_TYPE_REFLECTED], CALIBRATION_LUT_COUNT);
+    Serial.print(line);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "Arduino.h"
+#include <atomic>
+#include "types.h"
+
+#define CALIBRATION_NAMESPACE "calibration"
+#define CALIBRATION_KEY "points"
+#define CALIBRATION_VERSION 1
+
+#define CALIBRATION_POINT_MAX 16
+
+/*
+  Correction table over log2(lux) in 1/8 stops, from below EXPOSURE_LUX_MIN
+  to above a saturated reading at the least sensitive range
+*/
+#define CALIBRATION_LUT_MIN_STOPS -10
+#define CALIBRATION_LUT_MAX_STOPS 18
+#define CALIBRATION_LUT_STEP_BITS 3
+#define CALIBRATION_LUT_COUNT (((CALIBRATION_LUT_MAX_STOPS - CALIBRATION_LUT_MIN_STOPS) << CALIBRATION_LUT_STEP_BITS) + 1)
+// Table entries keep 12 fraction bits, +-8 stops in an int16_t
+#define CALIBRATION_LUT_FRACTION_BITS 12
+
+// A point asking for more than this is a typo or the wrong scene, not a sensor error
+#define CALIBRATION_CORRECTION_MAX_STOPS 4
+
+// Points of a type closer than a table step are the same level measured again, the newer one replaces the older
+#define CALIBRATION_MERGE_STOPS 0.125f
+
+/*
+  One reading of the meter next to a reference meter. The raw register
+  values are kept rather than lux, so the point goes through the same
+  counts to log2 lux conversion as every sample
+*/
+typedef struct calibrationPoint_s {
+    uint16_t counts;
+    int16_t referenceEvHundredths; // Reference meter, EV at ISO 100
+    uint8_t type;                  // lightMeterMode_e the reference was metered in
+    uint8_t gain;
+    uint8_t integrationTime;
+} calibrationPoint_t;
+
+typedef struct calibrationLut_s {
+    int16_t correction[LIGHT_METER_TYPE_COUNT][CALIBRATION_LUT_COUNT];
+} calibrationLut_t;
+
+/*
+  Per device correction of the nominal sensor model. Points are kept in
+  NVS, begin() and every change expand the points of each meter type into
+  a dense table of EV corrections: linear in log2(lux) between points and
+  flat beyond the outermost ones, zero for a type without points. At run
+  time a correction is one interpolated table lookup.
+
+  Points are changed from the UI loop only while the sensor task keeps
+  solving, so there are two tables: the spare one is rebuilt and then
+  published with a single pointer store. A lookup pins the table it reads,
+  the next rebuild waits for a lookup still on the old table to finish
+  before it writes to it. Lookups never wait
+*/
+class Calibration {
+    public:
+        // Loads the points from NVS, an uncalibrated device corrects nothing
+        bool begin();
+        // Stops to add to the nominal EV of type at log2Lux, both EXPOSURE_FIXED_BITS fixed point
+        int32_t getCorrection(uint8_t type, int32_t log2Lux);
+        // Adds or replaces a point and saves, false when it is out of range or the table is full
+        bool addPoint(const calibrationPoint_t &point);
+        // Deletes every point of every type
+        bool clear();
+        uint8_t getPointCount() { return _count; }
+        const calibrationPoint_t &getPoint(uint8_t index) { return _points[index]; }
+        // Reference minus nominal EV at a point, what the curve corrects there, fixed point
+        static int32_t getPointCorrection(const calibrationPoint_t &point);
+        // One "calibration point=..." line per point and a summary line
+        void print();
+    private:
+        bool save();
+        void build();
+        calibrationPoint_t _points[CALIBRATION_POINT_MAX] = {};
+        uint8_t _count = 0;
+        calibrationLut_t _luts[2] = {};
+        std::atomic<uint8_t> _active{0};
+        // Lookups in progress per table
+        std::atomic<uint8_t> _readers[2] = {};
+};
+
+extern Calibration calibration;
+
+#endif
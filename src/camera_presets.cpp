@@ -0,0 +1,89 @@
+#include "camera_presets.h"
+#include "crc16.h"
+#include "byte_order.h"
+#include <LittleFS.h>
+
+// Magic, the presets and a CRC16 over both
+#define CAMERA_PRESETS_FILE_SIZE (1 + sizeof(cameraPresets_t) + 2)
+
+bool CameraPresets::begin() {
+    uint8_t data[CAMERA_PRESETS_FILE_SIZE];
+
+    // Mounted by the measurement log already, starts empty without a filesystem
+    if (!LittleFS.begin(true)) {
+        return false;
+    }
+
+    File file = LittleFS.open(CAMERA_PRESETS_FILE, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    const size_t size = file.read(data, sizeof(data));
+    file.close();
+
+    if (size != sizeof(data) || data[0] != CAMERA_PRESETS_MAGIC ||
+        getLe(data + CAMERA_PRESETS_FILE_SIZE - 2, 2) != crc16Ccitt(data, CAMERA_PRESETS_FILE_SIZE - 2)) {
+        return false;
+    }
+
+    memcpy(&_presets, data + 1, sizeof(cameraPresets_t));
+    if (_presets.increment >= STOP_INCREMENT_COUNT) {
+        _presets = {};
+        return false;
+    }
+    return true;
+}
+
+bool CameraPresets::save() {
+    uint8_t data[CAMERA_PRESETS_FILE_SIZE];
+
+    data[0] = CAMERA_PRESETS_MAGIC;
+    memcpy(data + 1, &_presets, sizeof(cameraPresets_t));
+
+    putLe(data + CAMERA_PRESETS_FILE_SIZE - 2, crc16Ccitt(data, CAMERA_PRESETS_FILE_SIZE - 2), 2);
+
+    File file = LittleFS.open(CAMERA_PRESETS_FILE, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+
+    const bool written = file.write(data, sizeof(data)) == sizeof(data);
+    file.close();
+    return written;
+}
+
+// Every preset to another stop increment, nearest step
+void CameraPresets::convert(uint8_t increment) {
+    for (uint8_t i = 0; i < CAMERA_PRESET_COUNT; i++) {
+        _presets.isoIndex[i] = stopConvertIndex(_presets.isoIndex[i], _presets.increment, increment);
+        _presets.shutterIndex[i] = stopConvertIndex(_presets.shutterIndex[i], _presets.increment, increment);
+    }
+    _presets.increment = increment;
+}
+
+void CameraPresets::select(uint8_t preset, settings_t *settings) {
+    _active = preset % CAMERA_PRESET_COUNT;
+
+    if (!isUsed(_active)) {
+        return;
+    }
+
+    settings->isoIndex = stopConvertIndex(_presets.isoIndex[_active], _presets.increment, settings->stopIncrement);
+    settings->shutterIndex = stopConvertIndex(_presets.shutterIndex[_active], _presets.increment, settings->stopIncrement);
+    settings->ndFilterIndex = _presets.ndFilterIndex[_active];
+}
+
+bool CameraPresets::store(const settings_t &settings) {
+    // Presets share one increment, stored ones follow the settings
+    if (_presets.increment != settings.stopIncrement) {
+        convert(settings.stopIncrement);
+    }
+
+    _presets.isoIndex[_active] = settings.isoIndex;
+    _presets.shutterIndex[_active] = settings.shutterIndex;
+    _presets.ndFilterIndex[_active] = settings.ndFilterIndex;
+    _presets.usedMask |= 1 << _active;
+
+    return save();
+}
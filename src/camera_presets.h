@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef CAMERA_PRESETS_H
+#define CAMERA_PRESETS_H
+
+#include "Arduino.h"
+#include "types.h"
+
+#define CAMERA_PRESET_COUNT 4
+#define CAMERA_PRESETS_FILE "/presets.bin"
+#define CAMERA_PRESETS_MAGIC 0x50
+
+/*
+  ISO, shutter and ND of every camera body, aperture is what a sample
+  solves for. One array per term, the batch solve walks each of them once
+  over all presets. Indexes are in steps of increment
+*/
+typedef struct cameraPresets_s {
+    int8_t isoIndex[CAMERA_PRESET_COUNT];
+    int8_t shutterIndex[CAMERA_PRESET_COUNT];
+    int8_t ndFilterIndex[CAMERA_PRESET_COUNT];
+    // Bit per stored preset
+    uint8_t usedMask;
+    uint8_t increment;
+} cameraPresets_t;
+
+/*
+  Loaded once from LittleFS and only written when a preset is stored.
+  Selecting another preset copies three bytes into the settings and never
+  schedules a save, the active preset only lives in RAM
+*/
+class CameraPresets {
+    public:
+        bool begin();
+        const cameraPresets_t &get() { return _presets; }
+        uint8_t getActive() { return _active; }
+        bool isUsed(uint8_t preset) { return _presets.usedMask & (1 << preset); }
+        // Makes preset the active one and takes over its values if it is stored
+        void select(uint8_t preset, settings_t *settings);
+        // Current settings into the active preset, saved right away
+        bool store(const settings_t &settings);
+    private:
+        bool save();
+        void convert(uint8_t increment);
+        cameraPresets_t _presets = {};
+        uint8_t _active = 0;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#include "crc16.h"
+
+uint16_t crc16Ccitt(const uint8_t *data, size_t size) {
+    uint16_t crc = 0xFFFF;
+
+    while (size--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include "Arduino.h"
+
+// CRC-16/CCITT-FALSE, shared by the settings journal and the telemetry frames
+uint16_t crc16Ccitt(const uint8_t *data, size_t size);
+
+#endif
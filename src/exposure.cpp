@@ -0,0 +1,169 @@
+#include "exposure.h"
+#include "calibration.h"
+
+// ND filter factor for ndFilterIndex from ND_FILTER_INDEX_MIN to ND_FILTER_INDEX_MAX
+static const uint16_t ND_FACTOR_TABLE[] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024
+};
+
+/*
+  log2(1 + i / 32) in EXPOSURE_FIXED_BITS fixed point, linear interpolation
+  in between is within 0.0002 stops
+*/
+#define EXPOSURE_MANTISSA_BITS 5
+
+static const uint32_t LOG2_MANTISSA_TABLE[] = {
+    0, 2909, 5732, 8473, 11136, 13727, 16248, 18704,
+    21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+    38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207,
+    52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+    65536
+};
+
+/*
+  Stop equation with every term in steps of the stop increment, Sv and Nd
+  counted from ISO 100 and no filter:
+
+  Av + Tv - Sv + Nd = EV(ISO100)
+
+  Every mode solves the same sum for one of the terms
+*/
+enum exposureTerm_e {
+    EXPOSURE_TERM_AV = 0,
+    EXPOSURE_TERM_TV,
+    EXPOSURE_TERM_SV,
+    EXPOSURE_TERM_ND,
+    EXPOSURE_TERM_COUNT
+};
+
+static const int8_t EXPOSURE_TERM_SIGN[EXPOSURE_TERM_COUNT] = {1, 1, -1, 1};
+
+// Free term of every compute mode, flicker mode has none
+#define EXPOSURE_TERM_NONE -1
+
+static const int8_t EXPOSURE_FREE_TERM[LIGHT_METER_MODE_COUNT] = {
+    EXPOSURE_TERM_AV,
+    EXPOSURE_TERM_TV,
+    EXPOSURE_TERM_SV,
+    EXPOSURE_TERM_ND,
+    EXPOSURE_TERM_NONE
+};
+
+static uint8_t exposureStepsPerStop(const settings_t &settings) {
+    return STOP_STEPS_PER_STOP[(settings.stopIncrement < STOP_INCREMENT_COUNT) ? settings.stopIncrement : (uint8_t)STOP_INCREMENT_FULL];
+}
+
+// Everything after the metered EV, shared by the float and the fixed point entry
+static void exposureSolveMetered(float meteredEv, int16_t meteredSteps, const settings_t &settings, exposureResult_t *result) {
+    const uint8_t steps = exposureStepsPerStop(settings);
+    // ND filters are counted in full stops whatever the increment
+    const int16_t ndSteps = settings.ndFilterIndex * steps;
+
+    result->ev = meteredEv + (float)settings.isoIndex / steps - settings.ndFilterIndex;
+    result->evSteps = meteredSteps + settings.isoIndex - ndSteps;
+
+    const int8_t freeTerm = (settings.mode < LIGHT_METER_MODE_COUNT) ? EXPOSURE_FREE_TERM[settings.mode] : EXPOSURE_TERM_NONE;
+    if (freeTerm == EXPOSURE_TERM_NONE) {
+        result->outputSteps = 0;
+        return;
+    }
+
+    const int16_t terms[EXPOSURE_TERM_COUNT] = {settings.apertureIndex, settings.shutterIndex, settings.isoIndex, ndSteps};
+
+    // Move every fixed term to the right hand side, the sign is +-1
+    int16_t rest = meteredSteps;
+    for (uint8_t term = 0; term < EXPOSURE_TERM_COUNT; term++) {
+        if (term != freeTerm) {
+            rest -= EXPOSURE_TERM_SIGN[term] * terms[term];
+        }
+    }
+    result->outputSteps = EXPOSURE_TERM_SIGN[freeTerm] * rest;
+}
+
+int32_t exposureNominalEvFixed(int32_t log2Lux, uint8_t type) {
+    return (type == LIGHT_METER_TYPE_REFLECTED) ? log2Lux + EXPOSURE_FIXED(EXPOSURE_REFLECTED_OFFSET)
+                                                : log2Lux - EXPOSURE_FIXED(EXPOSURE_INCIDENT_OFFSET);
+}
+
+void exposureSolve(float lux, const settings_t &settings, exposureResult_t *result) {
+    // Keep log2 finite in total darkness
+    if (lux < EXPOSURE_LUX_MIN) {
+        lux = EXPOSURE_LUX_MIN;
+    }
+
+    result->baseEv = log2f(lux);
+
+    // The correction table is indexed in fixed point, one conversion serves both lookups
+    const int32_t log2Lux = (int32_t)lroundf(result->baseEv * EXPOSURE_FIXED_ONE);
+    result->reflectedEv = result->baseEv + EXPOSURE_REFLECTED_OFFSET +
+                          (float)calibration.getCorrection(LIGHT_METER_TYPE_REFLECTED, log2Lux) / EXPOSURE_FIXED_ONE;
+    result->incidentEv = result->baseEv - EXPOSURE_INCIDENT_OFFSET +
+                         (float)calibration.getCorrection(LIGHT_METER_TYPE_INCIDENT, log2Lux) / EXPOSURE_FIXED_ONE;
+
+    const float meteredEv = (settings.type == LIGHT_METER_TYPE_REFLECTED) ? result->reflectedEv : result->incidentEv;
+    exposureSolveMetered(meteredEv, (int16_t)lroundf(meteredEv * exposureStepsPerStop(settings)), settings, result);
+}
+
+/*
+  Offsets and corrections are added in fixed point, floats are only filled
+  in for display and logging
+*/
+void exposureSolveFixed(int32_t log2Lux, const settings_t &settings, exposureResult_t *result) {
+    const int32_t reflected = exposureNominalEvFixed(log2Lux, LIGHT_METER_TYPE_REFLECTED) +
+                              calibration.getCorrection(LIGHT_METER_TYPE_REFLECTED, log2Lux);
+    const int32_t incident = exposureNominalEvFixed(log2Lux, LIGHT_METER_TYPE_INCIDENT) +
+                             calibration.getCorrection(LIGHT_METER_TYPE_INCIDENT, log2Lux);
+    const int32_t metered = (settings.type == LIGHT_METER_TYPE_REFLECTED) ? reflected : incident;
+
+    result->baseEv = (float)log2Lux / EXPOSURE_FIXED_ONE;
+    result->reflectedEv = (float)reflected / EXPOSURE_FIXED_ONE;
+    result->incidentEv = (float)incident / EXPOSURE_FIXED_ONE;
+
+    // The shift floors, half a step is added first to round
+    const int16_t meteredSteps = (int16_t)((metered * exposureStepsPerStop(settings) + EXPOSURE_FIXED_ONE / 2) >> EXPOSURE_FIXED_BITS);
+    exposureSolveMetered((float)metered / EXPOSURE_FIXED_ONE, meteredSteps, settings, result);
+}
+
+/*
+  Av = EV - Tv + Sv - Nd for all presets at once. The metered EV is rounded
+  once, the loop is three streams of bytes and no branches
+*/
+void exposureSolvePresets(const exposureResult_t &result, uint8_t type, const cameraPresets_t &presets, int16_t *apertureSteps) {
+    const uint8_t steps = STOP_STEPS_PER_STOP[(presets.increment < STOP_INCREMENT_COUNT) ? presets.increment : (uint8_t)STOP_INCREMENT_FULL];
+    const float meteredEv = (type == LIGHT_METER_TYPE_REFLECTED) ? result.reflectedEv : result.incidentEv;
+    const int16_t meteredSteps = (int16_t)lroundf(meteredEv * steps);
+
+    for (uint8_t i = 0; i < CAMERA_PRESET_COUNT; i++) {
+        apertureSteps[i] = meteredSteps - presets.shutterIndex[i] + presets.isoIndex[i] - presets.ndFilterIndex[i] * steps;
+    }
+}
+
+int32_t exposureLog2Fixed(uint32_t value) {
+    const int32_t exponent = 31 - __builtin_clz(value);
+    // Leading one at bit 31, the next bits index the table, the rest interpolate
+    const uint32_t normalized = value << (31 - exponent);
+    const uint32_t index = (normalized >> (31 - EXPOSURE_MANTISSA_BITS)) & ((1 << EXPOSURE_MANTISSA_BITS) - 1);
+    const uint32_t fraction = (normalized >> (31 - EXPOSURE_MANTISSA_BITS - EXPOSURE_FIXED_BITS)) & (EXPOSURE_FIXED_ONE - 1);
+    const uint32_t low = LOG2_MANTISSA_TABLE[index];
+
+    return exponent * EXPOSURE_FIXED_ONE + low + (((LOG2_MANTISSA_TABLE[index + 1] - low) * fraction) >> EXPOSURE_FIXED_BITS);
+}
+
+/*
+  Nearest full stop, half stops round up: x.33 rounds down and x.5 and x.67
+  round up for both signs
+*/
+int16_t exposureRoundToStops(int16_t steps, uint8_t stepsPerStop) {
+    const int16_t shifted = steps + stepsPerStop / 2;
+    int16_t stops = shifted / stepsPerStop;
+
+    if (shifted % stepsPerStop < 0) {
+        stops--;
+    }
+    return stops;
+}
+
+uint16_t exposureNdFactor(int8_t ndFilterIndex) {
+    ndFilterIndex = constrain(ndFilterIndex, ND_FILTER_INDEX_MIN, ND_FILTER_INDEX_MAX);
+    return ND_FACTOR_TABLE[ndFilterIndex - ND_FILTER_INDEX_MIN];
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef EXPOSURE_H
+#define EXPOSURE_H
+
+#include "Arduino.h"
+#include "types.h"
+#include "stop_tables.h"
+#include "camera_presets.h"
+
+/*
+  Exposure solver working in the log2 domain. All exposure terms are kept as
+  integer steps of the selected stop increment so that:
+
+  Av + Tv = EV(ISO100) + isoIndex - ndFilterIndex
+
+  where Av = log2(N^2) and Tv = -log2(t). Whichever term the mode leaves
+  free is solved from the same equation. A sample costs a single log2 of the
+  lux reading, everything else is integer arithmetic and the output is an
+  index into the stop tables
+*/
+
+/*
+  Nominal sensor model, the per device curve in calibration.h corrects on
+  top of it. Incident calibration constant 2.5 folded into the log domain:
+  log2(2.5)
+*/
+#define EXPOSURE_INCIDENT_OFFSET 1.321928f
+#define EXPOSURE_REFLECTED_OFFSET 3.0f
+
+// Below VEML7700 resolution, used instead of 0 lux
+#define EXPOSURE_LUX_MIN 0.001f
+
+/*
+  Fixed point log2 values, 16 fraction bits. EXPOSURE_FIXED only for
+  constants, it folds at compile time
+*/
+#define EXPOSURE_FIXED_BITS 16
+#define EXPOSURE_FIXED_ONE (1L << EXPOSURE_FIXED_BITS)
+#define EXPOSURE_FIXED(value) ((int32_t)((value) * EXPOSURE_FIXED_ONE + ((value) < 0 ? -0.5f : 0.5f)))
+
+typedef struct exposureResult_s {
+    float baseEv;       // log2(lux), shared by reflected and incident EV
+    // Calibrated, EV at ISO 100
+    float reflectedEv;
+    float incidentEv;
+    float ev;           // Effective EV for ISO and ND filter
+    int16_t evSteps;
+    int16_t outputSteps; // Av, Tv, ISO or ND in steps of settings.stopIncrement, whichever the mode solves for
+} exposureResult_t;
+
+// Float reference of exposureSolveFixed, only the benchmarks and host checks compare against it
+void exposureSolve(float lux, const settings_t &settings, exposureResult_t *result);
+// Every sample is solved here, from log2(lux) in fixed point, see LightSensor::countsToLog2Lux
+void exposureSolveFixed(int32_t log2Lux, const settings_t &settings, exposureResult_t *result);
+// Av of every preset from the EV metered for result, in steps of presets.increment
+void exposureSolvePresets(const exposureResult_t &result, uint8_t type, const cameraPresets_t &presets, int16_t *apertureSteps);
+// EV at ISO 100 of the nominal model for type, before calibration, fixed point
+int32_t exposureNominalEvFixed(int32_t log2Lux, uint8_t type);
+// log2 of a non zero value, CLZ for the integer part and a mantissa table
+int32_t exposureLog2Fixed(uint32_t value);
+
+int16_t exposureRoundToStops(int16_t steps, uint8_t stepsPerStop);
+uint16_t exposureNdFactor(int8_t ndFilterIndex);
+
+#endif
@@ -0,0 +1,121 @@
+#include "flicker.h"
+
+// Goertzel coefficients 2cos(2 pi k / FLICKER_SAMPLE_COUNT) in Q14, k = 0 to FLICKER_BIN_COUNT
+static const int32_t GOERTZEL_COEFFICIENTS[] = {
+    32768, 32610, 32138, 31357, 30274, 28899, 27246, 25330,
+    23170, 20788, 18205, 15447, 12540, 9512, 6393, 3212,
+    0, -3212, -6393, -9512, -12540, -15447, -18205, -20788,
+    -23170, -25330, -27246, -28899, -30274, -31357, -32138, -32610,
+    -32768
+};
+
+static_assert(sizeof(GOERTZEL_COEFFICIENTS) / sizeof(GOERTZEL_COEFFICIENTS[0]) == FLICKER_BIN_COUNT + 1,
+              "one coefficient per bin");
+
+void FlickerAnalyzer::reset() {
+    _count = 0;
+}
+
+bool FlickerAnalyzer::addSample(uint16_t counts) {
+    if (_count < FLICKER_SAMPLE_COUNT) {
+        _samples[_count++] = counts;
+    }
+    return _count == FLICKER_SAMPLE_COUNT;
+}
+
+// Squared DFT magnitude of bin k, samples are mean removed
+static int64_t goertzelPower(const int32_t *samples, uint8_t k) {
+    const int32_t coefficient = GOERTZEL_COEFFICIENTS[k];
+    int32_t s1 = 0;
+    int32_t s2 = 0;
+
+    for (uint8_t i = 0; i < FLICKER_SAMPLE_COUNT; i++) {
+        const int32_t s0 = samples[i] + (int32_t)(((int64_t)coefficient * s1) >> 14) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    return (int64_t)s1 * s1 + (int64_t)s2 * s2 - (((int64_t)coefficient * s1) >> 14) * s2;
+}
+
+void FlickerAnalyzer::analyze(flickerResult_t *result) {
+    int32_t samples[FLICKER_SAMPLE_COUNT];
+    int64_t power[FLICKER_BIN_COUNT + 1] = {0};
+    uint32_t sum = 0;
+
+    memset(result, 0, sizeof(flickerResult_t));
+
+    if (_count < FLICKER_SAMPLE_COUNT) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < FLICKER_SAMPLE_COUNT; i++) {
+        sum += _samples[i];
+    }
+    const int32_t mean = sum / FLICKER_SAMPLE_COUNT;
+    result->meanCounts = mean;
+    reset();
+
+    if (mean == 0) {
+        return;
+    }
+
+    // Flicker index: area above the mean over the total area
+    uint32_t above = 0;
+    for (uint8_t i = 0; i < FLICKER_SAMPLE_COUNT; i++) {
+        samples[i] = (int32_t)_samples[i] - mean;
+        if (samples[i] > 0) {
+            above += samples[i];
+        }
+    }
+    result->flickerIndex = (uint64_t)above * 1000 / sum;
+
+    // DC is gone with the mean, Nyquist has no usable phase
+    uint8_t peak = 1;
+    for (uint8_t k = 1; k < FLICKER_BIN_COUNT; k++) {
+        power[k] = goertzelPower(samples, k);
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+
+    /*
+      A component between bins leaks into both neighbours, their sum keeps
+      the amplitude within a few percent wherever it falls
+    */
+    const float amplitude = 2.0f * sqrtf((float)(power[peak - 1] + power[peak] + power[peak + 1])) / FLICKER_SAMPLE_COUNT;
+    const uint32_t depth = lroundf(amplitude * 1000 / mean);
+
+    if (depth < FLICKER_DEPTH_MIN) {
+        return;
+    }
+
+    // Parabolic interpolation between the neighbouring bins
+    float offset = 0;
+    if (peak > 1 && peak < FLICKER_BIN_COUNT - 1) {
+        const float left = sqrtf((float)power[peak - 1]);
+        const float center = sqrtf((float)power[peak]);
+        const float right = sqrtf((float)power[peak + 1]);
+        const float denominator = left - 2 * center + right;
+
+        if (denominator != 0) {
+            offset = constrain(0.5f * (left - right) / denominator, -0.5f, 0.5f);
+        }
+    }
+
+    const float binHz = 1000.0f / (FLICKER_SAMPLE_PERIOD_MS * FLICKER_SAMPLE_COUNT);
+    result->frequencyTenths = lroundf((peak + offset) * binHz * 10);
+    result->depthPerMille = depth > 1000 ? 1000 : depth;
+}
+
+uint16_t flickerAtShutter(const flickerResult_t &result, float shutterSeconds) {
+    if (result.frequencyTenths == 0) {
+        return 0;
+    }
+
+    // Averaging a sine over time t scales it by |sinc(f t)|
+    const float cycles = result.frequencyTenths / 10.0f * shutterSeconds;
+    const float attenuation = fabsf(sinf(PI * cycles) / (PI * cycles));
+
+    return lroundf(result.depthPerMille * attenuation);
+}
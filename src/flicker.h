@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef FLICKER_H
+#define FLICKER_H
+
+#include "Arduino.h"
+
+/*
+  The VEML7700 back to back at its shortest integration time, 25ms, gives
+  40 samples per second. Each sample is the average over its integration
+  window, so 100/120Hz mains ripple is mostly (120Hz entirely) integrated
+  away and what can be resolved is flicker below 20Hz: failing tubes,
+  dimmer and PWM driver beat, the slow pulsing that rolls through footage
+*/
+#define FLICKER_SAMPLE_PERIOD_MS 25
+#define FLICKER_SAMPLE_COUNT 64
+#define FLICKER_BIN_COUNT (FLICKER_SAMPLE_COUNT / 2)
+
+// Modulation depth in per mille below which the light counts as steady
+#define FLICKER_DEPTH_MIN 20
+
+typedef struct flickerResult_s {
+    uint16_t meanCounts;
+    // IES flicker index of the sampled waveform, per mille
+    uint16_t flickerIndex;
+    // Dominant flicker component, 0 when the light is steady
+    uint16_t frequencyTenths;
+    // Modulation depth of the dominant component, per mille of the mean
+    uint16_t depthPerMille;
+} flickerResult_t;
+
+/*
+  Collects one buffer of samples and runs a fixed-point Goertzel over every
+  DFT bin between DC and Nyquist. Integer only in the sample loops, the few
+  float operations are done once per buffer
+*/
+class FlickerAnalyzer {
+    public:
+        void reset();
+        // Returns true once the buffer is full and ready for analyze()
+        bool addSample(uint16_t counts);
+        void analyze(flickerResult_t *result);
+    private:
+        uint16_t _samples[FLICKER_SAMPLE_COUNT];
+        uint8_t _count = 0;
+};
+
+/*
+  Modulation depth left after integrating over the shutter time, what the
+  camera sees frame to frame. Zero when the shutter spans whole periods
+*/
+uint16_t flickerAtShutter(const flickerResult_t &result, float shutterSeconds);
+
+#endif
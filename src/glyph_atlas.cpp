@@ -0,0 +1,53 @@
+#include "glyph_atlas.h"
+#include "oled_flush.h"
+
+const glyphAtlasSet_t *GlyphAtlas::findSet(const uint8_t *font, uint8_t shift) {
+    for (uint8_t i = 0; i < _setCount; i++) {
+        if (_sets[i].font == font && _sets[i].shift == shift) {
+            return &_sets[i];
+        }
+    }
+    return nullptr;
+}
+
+bool GlyphAtlas::drawString(uint8_t *buffer, int16_t x, int16_t y, const uint8_t *font, const char *text) {
+    if (!_enabled || y < 0) {
+        return false;
+    }
+
+    const glyphAtlasSet_t *set = findSet(font, y & 7);
+    if (set == nullptr) {
+        return false;
+    }
+
+    // All or nothing, the font path draws the whole string otherwise
+    for (const char *c = text; *c; c++) {
+        const uint8_t index = (uint8_t)*c - GLYPH_ATLAS_FIRST_CHAR;
+        if (index >= GLYPH_ATLAS_CHAR_COUNT || set->glyphs[index] == GLYPH_ATLAS_NONE) {
+            return false;
+        }
+    }
+
+    const uint8_t firstPage = y >> 3;
+    const uint8_t pages = (firstPage + set->pages > OLED_PAGE_ROW_COUNT) ? OLED_PAGE_ROW_COUNT - firstPage : set->pages;
+
+    for (const char *c = text; *c; c++) {
+        const glyphAtlasGlyph_t &glyph = _glyphs[set->glyphs[(uint8_t)*c - GLYPH_ATLAS_FIRST_CHAR]];
+        const uint8_t *data = &_pool[glyph.offset];
+
+        for (uint8_t column = 0; column < glyph.columns; column++, data += set->pages) {
+            const int16_t columnX = x + column;
+            if (columnX < 0 || columnX >= OLED_WIDTH) {
+                continue;
+            }
+
+            uint8_t *target = &buffer[firstPage * OLED_WIDTH + columnX];
+            for (uint8_t page = 0; page < pages; page++, target += OLED_WIDTH) {
+                *target |= data[page];
+            }
+        }
+        x += glyph.advance;
+    }
+
+    return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include "Arduino.h"
+
+// Limits of the sizing pass, the tables themselves are generated at their exact size
+#define GLYPH_ATLAS_SET_COUNT 10
+// Glyphs are indexed by a byte below GLYPH_ATLAS_NONE
+#define GLYPH_ATLAS_GLYPH_COUNT 240
+#define GLYPH_ATLAS_POOL_SIZE 6144
+// Printable ASCII
+#define GLYPH_ATLAS_FIRST_CHAR 32
+#define GLYPH_ATLAS_CHAR_COUNT 95
+#define GLYPH_ATLAS_NONE 0xFF
+
+// ThingPulse font header: width, height, first char, char count, then 4 byte jump table entries
+#define GLYPH_ATLAS_FONT_HEADER_SIZE 4
+#define GLYPH_ATLAS_FONT_JUMP_SIZE 4
+
+typedef struct glyphAtlasGlyph_s {
+    uint16_t offset;
+    uint8_t advance;
+    uint8_t columns;
+} glyphAtlasGlyph_t;
+
+// Glyphs of one font rasterized for rows starting at y % 8 == shift
+typedef struct glyphAtlasSet_s {
+    const uint8_t *font;
+    uint8_t shift;
+    uint8_t pages;
+    uint8_t glyphs[GLYPH_ATLAS_CHAR_COUNT];
+} glyphAtlasSet_t;
+
+// A text position and the chars it can show, rows sharing y % 8 share a set
+typedef struct glyphAtlasText_s {
+    const uint8_t *font;
+    int16_t y;
+    const char *chars;
+} glyphAtlasText_t;
+
+template <uint8_t Sets, uint8_t Glyphs, uint16_t Bytes> struct glyphAtlasTables_s {
+    glyphAtlasSet_t sets[Sets];
+    glyphAtlasGlyph_t glyphs[Glyphs];
+    uint8_t pool[Bytes];
+    uint8_t setCount;
+    uint8_t glyphCount;
+    uint16_t poolUsed;
+    // False when a char is missing from its font or the tables ran out of room
+    bool complete;
+};
+
+// Same decoding as the ThingPulse renderer, straight into shifted page bytes
+template <class Tables> constexpr bool glyphAtlasRasterize(Tables &tables, glyphAtlasSet_t &set, char c) {
+    const uint8_t index = (uint8_t)c - GLYPH_ATLAS_FIRST_CHAR;
+    const uint8_t *font = set.font;
+    const uint8_t firstChar = font[2];
+    const uint8_t charCount = font[3];
+
+    if (index >= GLYPH_ATLAS_CHAR_COUNT || (uint8_t)c < firstChar || (uint8_t)c - firstChar >= charCount) {
+        return false;
+    }
+    if (set.glyphs[index] != GLYPH_ATLAS_NONE) {
+        return true;
+    }
+
+    const uint8_t *jump = font + GLYPH_ATLAS_FONT_HEADER_SIZE + ((uint8_t)c - firstChar) * GLYPH_ATLAS_FONT_JUMP_SIZE;
+    const uint16_t offset = (jump[0] << 8) | jump[1];
+    const uint8_t size = jump[2];
+    const uint8_t rasterHeight = 1 + ((font[1] - 1) >> 3);
+    // 0xFFFF marks a glyph without pixels, a space
+    const uint8_t columns = (offset == 0xFFFF) ? 0 : (size + rasterHeight - 1) / rasterHeight;
+    const uint16_t bytes = columns * set.pages;
+
+    if (tables.glyphCount == sizeof(tables.glyphs) / sizeof(tables.glyphs[0]) ||
+        tables.poolUsed + bytes > sizeof(tables.pool)) {
+        return false;
+    }
+
+    glyphAtlasGlyph_t &glyph = tables.glyphs[tables.glyphCount];
+    const uint8_t *source = font + GLYPH_ATLAS_FONT_HEADER_SIZE + charCount * GLYPH_ATLAS_FONT_JUMP_SIZE + offset;
+
+    glyph.offset = tables.poolUsed;
+    glyph.advance = jump[3];
+    glyph.columns = columns;
+
+    for (uint8_t i = 0; i < size && columns > 0; i++) {
+        const uint16_t bits = (uint16_t)source[i] << set.shift;
+        const uint16_t column = tables.poolUsed + (i / rasterHeight) * set.pages;
+        const uint8_t page = i % rasterHeight;
+
+        tables.pool[column + page] |= bits & 0xFF;
+        if (page + 1 < set.pages) {
+            tables.pool[column + page + 1] |= bits >> 8;
+        }
+    }
+
+    set.glyphs[index] = tables.glyphCount++;
+    tables.poolUsed += bytes;
+    return true;
+}
+
+// Every char of every text, rasterized once per font and row shift
+template <uint8_t Sets, uint8_t Glyphs, uint16_t Bytes, size_t Count>
+constexpr glyphAtlasTables_s<Sets, Glyphs, Bytes> glyphAtlasBuild(const glyphAtlasText_t (&texts)[Count]) {
+    glyphAtlasTables_s<Sets, Glyphs, Bytes> tables = {};
+
+    tables.complete = true;
+
+    for (const glyphAtlasText_t &text : texts) {
+        const uint8_t shift = text.y & 7;
+        uint8_t set = 0;
+
+        while (set < tables.setCount && (tables.sets[set].font != text.font || tables.sets[set].shift != shift)) {
+            set++;
+        }
+
+        if (set == tables.setCount) {
+            if (tables.setCount == Sets) {
+                tables.complete = false;
+                continue;
+            }
+            tables.setCount++;
+            tables.sets[set].font = text.font;
+            tables.sets[set].shift = shift;
+            tables.sets[set].pages = (shift + text.font[1] + 7) / 8;
+            for (uint8_t &glyph : tables.sets[set].glyphs) {
+                glyph = GLYPH_ATLAS_NONE;
+            }
+        }
+
+        for (const char *c = text.chars; *c; c++) {
+            tables.complete = glyphAtlasRasterize(tables, tables.sets[set], *c) && tables.complete;
+        }
+    }
+    return tables;
+}
+
+/*
+  Glyphs decoded at compile time from the ThingPulse font format into
+  SSD1306 page layout, already shifted to the row they are drawn at, and
+  kept in flash. Drawing a string is then a byte OR per column and page,
+  no jump table lookups, no bit shifting and no String temporary. Each
+  text position on the pages has a fixed y, so a handful of font and shift
+  sets cover everything
+*/
+class GlyphAtlas {
+    public:
+        template <uint8_t Sets, uint8_t Glyphs, uint16_t Bytes>
+        GlyphAtlas(const glyphAtlasTables_s<Sets, Glyphs, Bytes> &tables)
+            : _sets(tables.sets), _setCount(tables.setCount), _glyphs(tables.glyphs), _glyphCount(tables.glyphCount),
+              _pool(tables.pool), _poolSize(tables.poolUsed) {
+        }
+        // Nothing is drawn and false returned if any char or the font and row are not in the atlas
+        bool drawString(uint8_t *buffer, int16_t x, int16_t y, const uint8_t *font, const char *text);
+        void setEnabled(bool enabled) { _enabled = enabled; }
+        uint16_t getUsedBytes() { return _poolSize; }
+        uint8_t getGlyphCount() { return _glyphCount; }
+    private:
+        const glyphAtlasSet_t *findSet(const uint8_t *font, uint8_t shift);
+        const glyphAtlasSet_t *_sets;
+        uint8_t _setCount;
+        const glyphAtlasGlyph_t *_glyphs;
+        uint8_t _glyphCount;
+        const uint8_t *_pool;
+        uint16_t _poolSize;
+        bool _enabled = true;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "i2c_arbiter.h"
+
+static const char *const I2C_CLIENT_NAMES[I2C_CLIENT_COUNT] = {
+    "sensor",
+    "display"
+};
+
+void I2cArbiter::begin(TwoWire *wire) {
+    _wire = wire;
+    refreshClock();
+    _beginAt = millis();
+
+    for (uint8_t client = 0; client < I2C_CLIENT_COUNT; client++) {
+        _grant[client] = xSemaphoreCreateBinary();
+    }
+}
+
+bool I2cArbiter::tryAcquire(i2cClient_e client) {
+    bool granted;
+
+    portENTER_CRITICAL(&_mux);
+    granted = _owner == I2C_CLIENT_NONE;
+    if (granted) {
+        _owner = client;
+    } else {
+        _waiting |= 1 << client;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    return granted;
+}
+
+void I2cArbiter::acquire(i2cClient_e client) {
+    if (tryAcquire(client)) {
+        return;
+    }
+
+    // release() makes the client the owner before it gives the semaphore
+    const uint32_t waitStart = micros();
+    xSemaphoreTake(_grant[client], portMAX_DELAY);
+    const uint32_t waited = micros() - waitStart;
+
+    _stats[client].waits++;
+    if (waited > _stats[client].maxWaitMicros) {
+        _stats[client].maxWaitMicros = waited;
+    }
+}
+
+void I2cArbiter::release(i2cClient_e client, uint16_t bytes) {
+    i2cClientStats_t &stats = _stats[client];
+    uint8_t next = I2C_CLIENT_NONE;
+
+    // Still the owner, nobody else writes these
+    stats.transactions++;
+    stats.bytes += bytes;
+    stats.busMicros += (uint64_t)bytes * I2C_ARBITER_CLOCKS_PER_BYTE * 1000000 / _clockHz;
+    if (bytes > stats.maxTransactionBytes) {
+        stats.maxTransactionBytes = bytes;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    if (_waiting != 0) {
+        next = __builtin_ctz(_waiting);
+        _waiting &= ~(1 << next);
+    }
+    _owner = next;
+    portEXIT_CRITICAL(&_mux);
+
+    if (next != I2C_CLIENT_NONE) {
+        xSemaphoreGive(_grant[next]);
+    }
+}
+
+uint16_t I2cArbiter::getOccupancyPerMille(i2cClient_e client) {
+    const uint64_t elapsedMicros = (uint64_t)(millis() - _beginAt) * 1000;
+
+    return (elapsedMicros > 0) ? _stats[client].busMicros * 1000 / elapsedMicros : 0;
+}
+
+void I2cArbiter::print() {
+    char line[160];
+
+    for (uint8_t client = 0; client < I2C_CLIENT_COUNT; client++) {
+        const i2cClientStats_t &stats = _stats[client];
+
+        snprintf(line, sizeof(line),
+                 "i2c client=%s transactions=%lu bytes=%lu bus_us=%llu occupancy_per_mille=%u max_transaction_bytes=%u waits=%lu max_wait_us=%lu\n",
+                 I2C_CLIENT_NAMES[client], (unsigned long)stats.transactions, (unsigned long)stats.bytes,
+                 (unsigned long long)stats.busMicros, getOccupancyPerMille((i2cClient_e)client), stats.maxTransactionBytes,
+                 (unsigned long)stats.waits, (unsigned long)stats.maxWaitMicros);
+        Serial.print(line);
+    }
+}
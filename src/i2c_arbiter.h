@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef I2C_ARBITER_H
+#define I2C_ARBITER_H
+
+#include "Arduino.h"
+#include <Wire.h>
+
+// In priority order, a waiting sensor access goes before the next display chunk
+enum i2cClient_e {
+    I2C_CLIENT_SENSOR = 0,
+    I2C_CLIENT_DISPLAY,
+    I2C_CLIENT_COUNT
+};
+
+#define I2C_CLIENT_NONE 0xFF
+
+// Bus clocks per byte, 8 data bits and the acknowledge
+#define I2C_ARBITER_CLOCKS_PER_BYTE 9
+
+typedef struct i2cClientStats_s {
+    uint32_t transactions;
+    uint32_t bytes;
+    // Bus time of the bytes at the bus clock, what the client kept the others off
+    uint64_t busMicros;
+    // Longest a higher priority client can wait behind this one
+    uint16_t maxTransactionBytes;
+    // Acquisitions that found the bus taken, and the longest of those waits
+    uint32_t waits;
+    uint32_t maxWaitMicros;
+} i2cClientStats_t;
+
+/*
+  Arbiter for the bus the VEML7700 and the SSD1306 share, used from the
+  sensor task on core 0 and the UI loop on core 1. Every transaction is
+  bracketed by acquire() and release(). Waiting clients queue by priority
+  and release() hands the bus straight to the highest one, so a client
+  with a large transfer has to split it: the display flush is arbitrated
+  per data chunk, a sensor read never waits behind a whole frame
+*/
+class I2cArbiter {
+    public:
+        void begin(TwoWire *wire);
+        // Bus time is accounted at the clock read here, call it after a driver changed it
+        void refreshClock() { _clockHz = _wire->getClock(); }
+        // Blocks until the bus is granted
+        void acquire(i2cClient_e client);
+        // Non-blocking, queues the client when the bus is taken
+        bool tryAcquire(i2cClient_e client);
+        // Bus bytes of the transaction, address bytes included
+        void release(i2cClient_e client, uint16_t bytes);
+        uint8_t getOwner() { return _owner; }
+        const i2cClientStats_t &getStats(i2cClient_e client) { return _stats[client]; }
+        // Share of the time since begin() the client held the bus for
+        uint16_t getOccupancyPerMille(i2cClient_e client);
+        // One "i2c client=..." line per client
+        void print();
+    private:
+        TwoWire *_wire = nullptr;
+        uint32_t _clockHz = 100000;
+        uint32_t _beginAt = 0;
+        SemaphoreHandle_t _grant[I2C_CLIENT_COUNT] = {};
+        portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+        volatile uint8_t _owner = I2C_CLIENT_NONE;
+        // Bit per waiting client, the lowest one is served first
+        volatile uint8_t _waiting = 0;
+        i2cClientStats_t _stats[I2C_CLIENT_COUNT] = {};
+};
+
+extern I2cArbiter i2cArbiter;
+
+#endif
@@ -0,0 +1,152 @@
+#include "input.h"
+
+typedef struct inputButton_s {
+    uint8_t pin;
+    button_e button;
+    volatile bool pressed;
+    volatile bool longReported;
+    volatile uint32_t pressStart;
+    volatile uint32_t lastEdge;
+} inputButton_t;
+
+static inputButton_t inputButtons[BUTTON_COUNT];
+static QueueHandle_t inputQueue = NULL;
+static portMUX_TYPE inputMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Press on release, unless the long press was reported while the button was held
+static inputPress_e IRAM_ATTR inputReleasePress(const inputButton_t *button, uint32_t now) {
+    const uint32_t held = now - button->pressStart;
+
+    if (button->longReported || held < INPUT_MIN_PRESS_MS) {
+        return INPUT_PRESS_NONE;
+    }
+    return (held >= INPUT_LONG_PRESS_MS) ? INPUT_PRESS_LONG : INPUT_PRESS_SHORT;
+}
+
+static void IRAM_ATTR inputIsr(void *arg) {
+    inputButton_t *button = (inputButton_t *)arg;
+    const uint32_t now = millis();
+    const bool pressed = digitalRead(button->pin) == LOW;
+    bool edge = false;
+    inputPress_e press = INPUT_PRESS_NONE;
+
+    portENTER_CRITICAL_ISR(&inputMux);
+    if (pressed != button->pressed && now - button->lastEdge >= INPUT_DEBOUNCE_MS) {
+        edge = true;
+        button->lastEdge = now;
+        button->pressed = pressed;
+
+        if (pressed) {
+            button->pressStart = now;
+            button->longReported = false;
+        } else {
+            press = inputReleasePress(button, now);
+        }
+    }
+    portEXIT_CRITICAL_ISR(&inputMux);
+
+    // The press edge wakes the loop, it has to time a long press while the button is held
+    if (edge && (pressed || press != INPUT_PRESS_NONE)) {
+        const inputEvent_t event = {pressed ? INPUT_EVENT_PRESS : INPUT_EVENT_BUTTON, button->button, press, now};
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+        xQueueSendFromISR(inputQueue, &event, &higherPriorityTaskWoken);
+        if (higherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+void inputBegin(const uint8_t pins[BUTTON_COUNT]) {
+    inputQueue = xQueueCreate(INPUT_QUEUE_LENGTH, sizeof(inputEvent_t));
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        inputButton_t *button = &inputButtons[i];
+
+        button->pin = pins[i];
+        button->button = (button_e)i;
+        button->pressed = false;
+        button->longReported = false;
+        button->pressStart = 0;
+        button->lastEdge = 0;
+
+        pinMode(button->pin, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(button->pin), inputIsr, button, CHANGE);
+    }
+}
+
+/*
+  While a button is held, wake up often enough to report the long press on
+  time and to recover a release edge that was dropped as bounce
+*/
+static TickType_t inputGetTimeout() {
+    return inputIsIdle() ? portMAX_DELAY : INPUT_DEBOUNCE_MS / portTICK_PERIOD_MS;
+}
+
+bool inputIsIdle() {
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (inputButtons[i].pressed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool inputWaitEvent(inputEvent_t *event) {
+    return xQueueReceive(inputQueue, event, inputGetTimeout()) == pdTRUE;
+}
+
+void inputPoll() {
+    const uint32_t now = millis();
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        inputButton_t *button = &inputButtons[i];
+        inputPress_e press = INPUT_PRESS_NONE;
+
+        if (!button->pressed) {
+            continue;
+        }
+
+        const bool released = digitalRead(button->pin) == HIGH;
+
+        portENTER_CRITICAL(&inputMux);
+        if (released && now - button->lastEdge >= INPUT_DEBOUNCE_MS) {
+            // Release edge was lost to debouncing
+            button->pressed = false;
+            button->lastEdge = now;
+            press = inputReleasePress(button, now);
+        } else if (!released && !button->longReported && now - button->pressStart >= INPUT_LONG_PRESS_MS) {
+            button->longReported = true;
+            press = INPUT_PRESS_LONG;
+        }
+        portEXIT_CRITICAL(&inputMux);
+
+        if (press != INPUT_PRESS_NONE) {
+            const inputEvent_t event = {INPUT_EVENT_BUTTON, button->button, press, now};
+            xQueueSend(inputQueue, &event, 0);
+        }
+    }
+}
+
+void inputResume() {
+    const uint32_t now = millis();
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        inputButton_t *button = &inputButtons[i];
+
+        portENTER_CRITICAL(&inputMux);
+        if (!button->pressed && digitalRead(button->pin) == LOW) {
+            button->pressed = true;
+            button->longReported = false;
+            button->pressStart = now;
+            button->lastEdge = now;
+        }
+        portEXIT_CRITICAL(&inputMux);
+    }
+}
+
+// Called from the sensor task, a full queue means the UI is redrawing anyway
+void inputPostMeasurement() {
+    const inputEvent_t event = {INPUT_EVENT_MEASUREMENT, BUTTON_COUNT, INPUT_PRESS_NONE, millis()};
+    xQueueSend(inputQueue, &event, 0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "Arduino.h"
+
+// Same thresholds QmuTactile used for short and long press
+#define INPUT_MIN_PRESS_MS 40
+#define INPUT_LONG_PRESS_MS 1000
+
+// Edges closer than this to the previous accepted edge are contact bounce
+#define INPUT_DEBOUNCE_MS 20
+
+#define INPUT_QUEUE_LENGTH 16
+
+enum button_e {
+    BUTTON_MODE = 0,
+    BUTTON_UP,
+    BUTTON_DOWN,
+    BUTTON_LEFT,
+    BUTTON_RIGHT,
+    BUTTON_HOLD,
+    BUTTON_COUNT
+};
+
+enum inputPress_e {
+    INPUT_PRESS_NONE = 0,
+    INPUT_PRESS_SHORT,
+    INPUT_PRESS_LONG
+};
+
+enum inputEventType_e {
+    INPUT_EVENT_BUTTON = 0,
+    INPUT_EVENT_MEASUREMENT,
+    // A button went down, only wakes the loop so it times the press from now on
+    INPUT_EVENT_PRESS
+};
+
+typedef struct inputEvent_s {
+    inputEventType_e type;
+    button_e button;
+    inputPress_e press;
+    uint32_t timestamp;
+} inputEvent_t;
+
+/*
+  Interrupt driven buttons feeding a FreeRTOS queue. The GPIO interrupt
+  posts a wake up on press and the press on release, long press is posted
+  once the button was held for INPUT_LONG_PRESS_MS, from inputPoll() or
+  on release if the loop was late for it. The UI task blocks in
+  inputWaitEvent() and only wakes on input or a new measurement, while a
+  button is held it wakes every INPUT_DEBOUNCE_MS as well
+*/
+void inputBegin(const uint8_t pins[BUTTON_COUNT]);
+bool inputWaitEvent(inputEvent_t *event);
+void inputPoll();
+void inputPostMeasurement();
+// No button is held, nothing for inputPoll() to time
+bool inputIsIdle();
+/*
+  After light sleep: GPIO interrupts don't fire while asleep, a button that
+  woke the chip is taken as pressed from now on
+*/
+void inputResume();
+
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#ifndef LABELS_H
+#define LABELS_H
+
+/*
+  Display labels. constexpr pointer tables to string literals, both end up
+  in flash and nothing is copied to RAM or the heap at startup. Shutter,
+  aperture and ISO labels come with the stop tables
+*/
+static constexpr const char *const TYPE_TABLE[] = {"Incident", "Reflected"};
+
+#endif
@@ -0,0 +1,325 @@
+#include "light_sensor.h"
+#include "exposure.h"
+#include "i2c_arbiter.h"
+
+/*
+  Bus bytes for the arbiter stats, address bytes included. A register read
+  is 5, the driver changes settings read-modify-write, that is 9. begin()
+  probes the sensor and writes the whole configuration
+*/
+#define LIGHT_SENSOR_READ_BYTES 5
+#define LIGHT_SENSOR_UPDATE_BYTES 9
+#define LIGHT_SENSOR_BEGIN_BYTES (1 + 8 * LIGHT_SENSOR_UPDATE_BYTES)
+
+/*
+  Ordered from least to most sensitive, every step roughly doubles counts.
+  Low gains first as recommended by the VEML7700 application note
+*/
+static const lightSensorRange_t LIGHT_SENSOR_RANGES[] = {
+    {VEML7700_GAIN_1_8, VEML7700_IT_25MS, 0.125f, 25},
+    {VEML7700_GAIN_1_8, VEML7700_IT_50MS, 0.125f, 50},
+    {VEML7700_GAIN_1_8, VEML7700_IT_100MS, 0.125f, 100},
+    {VEML7700_GAIN_1_4, VEML7700_IT_100MS, 0.25f, 100},
+    {VEML7700_GAIN_1_4, VEML7700_IT_200MS, 0.25f, 200},
+    {VEML7700_GAIN_1, VEML7700_IT_100MS, 1.0f, 100},
+    {VEML7700_GAIN_1, VEML7700_IT_200MS, 1.0f, 200},
+    {VEML7700_GAIN_2, VEML7700_IT_200MS, 2.0f, 200},
+    {VEML7700_GAIN_2, VEML7700_IT_400MS, 2.0f, 400},
+    {VEML7700_GAIN_2, VEML7700_IT_800MS, 2.0f, 800}
+};
+
+#define LIGHT_SENSOR_RANGE_COUNT (sizeof(LIGHT_SENSOR_RANGES) / sizeof(LIGHT_SENSOR_RANGES[0]))
+
+// Shortest integration time for flicker sampling, least sensitive first
+static const lightSensorRange_t LIGHT_SENSOR_FLICKER_RANGES[] = {
+    {VEML7700_GAIN_1_8, VEML7700_IT_25MS, 0.125f, 25},
+    {VEML7700_GAIN_1_4, VEML7700_IT_25MS, 0.25f, 25},
+    {VEML7700_GAIN_1, VEML7700_IT_25MS, 1.0f, 25},
+    {VEML7700_GAIN_2, VEML7700_IT_25MS, 2.0f, 25}
+};
+
+#define LIGHT_SENSOR_FLICKER_RANGE_COUNT (sizeof(LIGHT_SENSOR_FLICKER_RANGES) / sizeof(LIGHT_SENSOR_FLICKER_RANGES[0]))
+
+// Lux per count at gain 1 and 25ms, log2 of it for the fixed point path
+#define LIGHT_SENSOR_LOG2_RESOLUTION_25MS -2.117787f
+
+// Integration time register value to doublings of 25ms, unused codes read as 100ms
+static const uint8_t INTEGRATION_TIME_DOUBLINGS[16] = {2, 3, 4, 5, 2, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2};
+
+// Gain register value to log2 of the gain: x1, x2, x1/8, x1/4
+static const int8_t GAIN_LOG2[4] = {0, 1, -3, -2};
+
+/*
+  log2 of the non-linearity correction in rangeCountsToLux, sampled every
+  1/8 stop from 1 lux to 2^17 lux, Q12. Interpolated it stays within 0.005
+  stops of the polynomial
+*/
+#define LIGHT_SENSOR_CORRECTION_STEP_BITS 3
+#define LIGHT_SENSOR_CORRECTION_FRACTION_BITS 12
+
+static const uint16_t LOG2_CORRECTION_TABLE[] = {
+    14, 14, 14, 14, 14, 14, 14, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 16, 16, 16, 16, 17, 17, 17,
+    17, 18, 18, 19, 19, 19, 20, 21,
+    21, 22, 23, 24, 24, 25, 26, 28,
+    29, 30, 32, 33, 35, 37, 39, 42,
+    44, 47, 50, 53, 56, 60, 64, 69,
+    74, 79, 85, 91, 98, 106, 114, 122,
+    132, 142, 153, 165, 178, 192, 207, 224,
+    241, 260, 280, 302, 325, 350, 377, 406,
+    436, 468, 502, 538, 576, 616, 658, 702,
+    748, 796, 845, 896, 949, 1003, 1058, 1115,
+    1174, 1235, 1299, 1367, 1441, 1522, 1616, 1727,
+    1861, 2028, 2239, 2509, 2854, 3291, 3839, 4512,
+    5321, 6271, 7356, 8567, 9887, 11298, 12782, 14321,
+    15902, 17510, 19138, 20777, 22422, 24069, 25716, 27359,
+    28998, 30633, 32262, 33885, 35502, 37114, 38721, 40322,
+    41919
+};
+
+#define LOG2_CORRECTION_COUNT (sizeof(LOG2_CORRECTION_TABLE) / sizeof(LOG2_CORRECTION_TABLE[0]))
+
+// Mid range, a sensible first guess indoors
+#define LIGHT_SENSOR_INITIAL_RANGE 3
+
+/*
+  Integration time tolerance, and the 2.5ms the VEML7700 needs out of
+  shutdown, as a share of the integration time
+*/
+#define LIGHT_SENSOR_START_MARGIN_SHIFT 2
+
+LightSensor::LightSensor(Adafruit_VEML7700 *veml) {
+    _veml = veml;
+}
+
+const lightSensorRange_t &LightSensor::getRange(uint8_t rangeIndex) {
+    return LIGHT_SENSOR_RANGES[rangeIndex < LIGHT_SENSOR_RANGE_COUNT ? rangeIndex : 0];
+}
+
+uint8_t LightSensor::getRangeCount() {
+    return LIGHT_SENSOR_RANGE_COUNT;
+}
+
+const lightSensorRange_t &LightSensor::currentRange() {
+    if (_flickerMode) {
+        return LIGHT_SENSOR_FLICKER_RANGES[_flickerRangeIndex];
+    }
+    return getRange(_rangeIndex);
+}
+
+/*
+  Counts to lux including the VEML7700 non-linearity correction, which
+  applies to the low gain ranges only
+*/
+float LightSensor::countsToLux(uint16_t counts, uint8_t rangeIndex) {
+    return rangeCountsToLux(counts, getRange(rangeIndex));
+}
+
+float LightSensor::rangeCountsToLux(uint16_t counts, const lightSensorRange_t &range) {
+    const float resolution = LIGHT_SENSOR_MAX_RESOLUTION * LIGHT_SENSOR_MAX_SENSITIVITY / (range.gainValue * range.integrationTimeMs);
+    float lux = counts * resolution;
+
+    if (range.gain == VEML7700_GAIN_1_8 || range.gain == VEML7700_GAIN_1_4) {
+        lux = (((6.0135e-13f * lux - 9.3924e-9f) * lux + 8.1488e-5f) * lux + 1.0023f) * lux;
+    }
+    return lux;
+}
+
+/*
+  Same conversion as countsToLux in the log2 domain, integer only: log2 of
+  the counts, minus log2 of gain and integration time, plus the correction
+  from the table for the low gains
+*/
+int32_t LightSensor::countsToLog2Lux(uint16_t counts, uint8_t gain, uint8_t integrationTime) {
+    // One count is the finest step the sensor has, log2(0) has no value
+    int32_t log2Lux = exposureLog2Fixed(counts > 0 ? counts : 1) + EXPOSURE_FIXED(LIGHT_SENSOR_LOG2_RESOLUTION_25MS) -
+                      ((int32_t)GAIN_LOG2[gain & 0x03] + INTEGRATION_TIME_DOUBLINGS[integrationTime & 0x0F]) * EXPOSURE_FIXED_ONE;
+
+    if (gain == VEML7700_GAIN_1_8 || gain == VEML7700_GAIN_1_4) {
+        const int32_t position = (log2Lux > 0) ? log2Lux : 0;
+        const uint32_t index = position >> (EXPOSURE_FIXED_BITS - LIGHT_SENSOR_CORRECTION_STEP_BITS);
+        const int32_t shift = EXPOSURE_FIXED_BITS - LIGHT_SENSOR_CORRECTION_FRACTION_BITS;
+
+        if (index >= LOG2_CORRECTION_COUNT - 1) {
+            log2Lux += (int32_t)LOG2_CORRECTION_TABLE[LOG2_CORRECTION_COUNT - 1] << shift;
+        } else {
+            const int32_t fraction = position & ((1 << (EXPOSURE_FIXED_BITS - LIGHT_SENSOR_CORRECTION_STEP_BITS)) - 1);
+            const int32_t low = LOG2_CORRECTION_TABLE[index];
+            const int32_t high = LOG2_CORRECTION_TABLE[index + 1];
+
+            log2Lux += (low << shift) + (((high - low) * fraction) >> (EXPOSURE_FIXED_BITS - LIGHT_SENSOR_CORRECTION_STEP_BITS - shift));
+        }
+    }
+    return log2Lux;
+}
+
+bool LightSensor::begin(TwoWire *wire) {
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    const bool found = _veml->begin(wire);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, LIGHT_SENSOR_BEGIN_BYTES);
+
+    if (!found) {
+        return false;
+    }
+
+    _beginAt = millis();
+    _timeToFirstValid = 0;
+
+    // Configured in shutdown, so the first conversion already runs in the initial range
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    _veml->enable(false);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, LIGHT_SENSOR_UPDATE_BYTES);
+
+    applyRange(LIGHT_SENSOR_INITIAL_RANGE);
+    _rangeChanges = 0;
+
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    _veml->enable(true);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, LIGHT_SENSOR_UPDATE_BYTES);
+    _rangeChangedAt = millis();
+
+    return true;
+}
+
+void LightSensor::configure(const lightSensorRange_t &range) {
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    _veml->setGain(range.gain);
+    // No wait, settling is tracked in update()
+    _veml->setIntegrationTime(range.integrationTime, false);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, 2 * LIGHT_SENSOR_UPDATE_BYTES);
+    _rangeChangedAt = millis();
+    _rangeChanges++;
+}
+
+void LightSensor::applyRange(uint8_t rangeIndex) {
+    _rangeIndex = rangeIndex;
+    configure(currentRange());
+}
+
+void LightSensor::applyFlickerRange(uint8_t flickerRangeIndex) {
+    _flickerRangeIndex = flickerRangeIndex;
+    configure(currentRange());
+}
+
+void LightSensor::setFlickerMode(bool enabled) {
+    if (enabled == _flickerMode) {
+        return;
+    }
+
+    if (!enabled) {
+        _flickerMode = false;
+        applyRange(_rangeIndex);
+        return;
+    }
+
+    // Most sensitive gain that leaves headroom for the flicker peaks
+    const lightSensorRange_t &range = currentRange();
+    const float signal = (_counts > 0 ? _counts : 1) / (range.gainValue * range.integrationTimeMs);
+    uint8_t flickerRangeIndex = 0;
+
+    for (uint8_t i = 0; i < LIGHT_SENSOR_FLICKER_RANGE_COUNT; i++) {
+        const lightSensorRange_t &candidate = LIGHT_SENSOR_FLICKER_RANGES[i];
+        if (signal * candidate.gainValue * candidate.integrationTimeMs <= LIGHT_SENSOR_COUNTS_TARGET) {
+            flickerRangeIndex = i;
+        }
+    }
+
+    _flickerMode = true;
+    applyFlickerRange(flickerRangeIndex);
+}
+
+void LightSensor::setPowerSave(bool enabled) {
+    if (enabled == _powerSave) {
+        return;
+    }
+
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    _veml->setPowerSaveMode(LIGHT_SENSOR_POWER_SAVE_MODE);
+    _veml->powerSaveEnable(enabled);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, 2 * LIGHT_SENSOR_UPDATE_BYTES);
+    _powerSave = enabled;
+}
+
+uint32_t LightSensor::getRefreshMs() {
+    return currentRange().integrationTimeMs + (_powerSave ? LIGHT_SENSOR_POWER_SAVE_WAIT_MS : 0);
+}
+
+/*
+  A conversion running into a range change may still be read back with
+  the old range, so the one after it is the first to trust. Out of
+  shutdown at boot there is no such conversion
+*/
+uint32_t LightSensor::getSettleMs() {
+    const uint32_t integrationTime = currentRange().integrationTimeMs;
+
+    if (_rangeChanges == 0) {
+        return integrationTime + (integrationTime >> LIGHT_SENSOR_START_MARGIN_SHIFT);
+    }
+    return getRefreshMs() + integrationTime;
+}
+
+uint32_t LightSensor::getSettleRemainingMs() {
+    const uint32_t elapsed = millis() - _rangeChangedAt;
+    const uint32_t settle = getSettleMs();
+
+    return (elapsed < settle) ? settle - elapsed : 0;
+}
+
+/*
+  Most sensitive range that still keeps the predicted counts under target.
+  A saturated reading says nothing about the actual level, so start over
+  from the least sensitive range
+*/
+uint8_t LightSensor::predictRange(uint16_t counts) {
+    if (counts >= LIGHT_SENSOR_COUNTS_SATURATED) {
+        return 0;
+    }
+
+    const float currentSensitivity = currentRange().gainValue * currentRange().integrationTimeMs;
+    const float signal = (counts > 0 ? counts : 1) / currentSensitivity;
+
+    for (int8_t i = LIGHT_SENSOR_RANGE_COUNT - 1; i > 0; i--) {
+        if (signal * LIGHT_SENSOR_RANGES[i].gainValue * LIGHT_SENSOR_RANGES[i].integrationTimeMs <= LIGHT_SENSOR_COUNTS_TARGET) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/*
+  Returns true when a valid reading is available, false while a range
+  change is still settling
+*/
+bool LightSensor::update() {
+    if (getSettleRemainingMs() > 0) {
+        return false;
+    }
+
+    i2cArbiter.acquire(I2C_CLIENT_SENSOR);
+    const uint16_t counts = _veml->readALS(false);
+    i2cArbiter.release(I2C_CLIENT_SENSOR, LIGHT_SENSOR_READ_BYTES);
+
+    if (_flickerMode) {
+        if (counts >= LIGHT_SENSOR_COUNTS_SATURATED && _flickerRangeIndex > 0) {
+            applyFlickerRange(_flickerRangeIndex - 1);
+            return false;
+        }
+    } else if (counts < LIGHT_SENSOR_COUNTS_LOW || counts > LIGHT_SENSOR_COUNTS_HIGH) {
+        const uint8_t rangeIndex = predictRange(counts);
+
+        if (rangeIndex != _rangeIndex) {
+            applyRange(rangeIndex);
+            return false;
+        }
+    }
+
+    _counts = counts;
+    _lux = rangeCountsToLux(counts, currentRange());
+
+    if (_timeToFirstValid == 0) {
+        _timeToFirstValid = millis() - _beginAt;
+    }
+
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef LIGHT_SENSOR_H
+#define LIGHT_SENSOR_H
+
+#include "Arduino.h"
+#include <Adafruit_VEML7700.h>
+
+// Lux per count at gain 2 and 800ms integration, scales with gain x IT
+#define LIGHT_SENSOR_MAX_RESOLUTION 0.0036f
+#define LIGHT_SENSOR_MAX_SENSITIVITY (2.0f * 800)
+
+/*
+  Hysteresis window in raw counts. Outside of it the next range is predicted
+  from the current reading so that counts land close to the target
+*/
+#define LIGHT_SENSOR_COUNTS_LOW 200
+#define LIGHT_SENSOR_COUNTS_HIGH 50000
+#define LIGHT_SENSOR_COUNTS_TARGET 10000
+#define LIGHT_SENSOR_COUNTS_SATURATED 65535
+
+// Power save mode 2 waits 1s between conversions, ~11uA instead of 45uA at 100ms
+#define LIGHT_SENSOR_POWER_SAVE_MODE VEML7700_POWERSAVE_MODE2
+#define LIGHT_SENSOR_POWER_SAVE_WAIT_MS 1000
+
+typedef struct lightSensorRange_s {
+    uint8_t gain;
+    uint8_t integrationTime;
+    float gainValue;
+    uint16_t integrationTimeMs;
+} lightSensorRange_t;
+
+/*
+  Non-blocking VEML7700 auto-ranging. The sensor runs in continuous mode and
+  update() only reads the last conversion, so a steady state sample costs one
+  I2C read instead of the gain/IT search with delays of VEML_LUX_AUTO.
+  After a range change readings are held back until the new integration
+  settled
+*/
+class LightSensor {
+    public:
+        LightSensor(Adafruit_VEML7700 *veml);
+        bool begin(TwoWire *wire = &Wire);
+        bool update();
+        float getLux() { return _lux; }
+        uint16_t getCounts() { return _counts; }
+        uint8_t getGain() { return currentRange().gain; }
+        uint8_t getIntegrationTime() { return currentRange().integrationTime; }
+        uint8_t getRangeIndex() { return _rangeIndex; }
+        // Lux for counts read in the current range
+        float getLuxForCounts(uint16_t counts) { return rangeCountsToLux(counts, currentRange()); }
+        /*
+          Fixed 25ms integration for flicker sampling, gain is picked once
+          from the last reading and only lowered on saturation
+        */
+        void setFlickerMode(bool enabled);
+        bool isFlickerMode() { return _flickerMode; }
+        /*
+          VEML7700 power save mode, conversions are spaced out and readings
+          only refresh every getRefreshMs(). Range changes keep working
+        */
+        void setPowerSave(bool enabled);
+        bool isPowerSave() { return _powerSave; }
+        // Time between two conversions in the current range
+        uint32_t getRefreshMs();
+        // Until update() trusts a reading again after a range change or begin(), 0 once it does
+        uint32_t getSettleRemainingMs();
+        uint32_t getRangeChanges() { return _rangeChanges; }
+        // Milliseconds from begin() to the first valid reading, 0 until then
+        uint32_t getTimeToFirstValid() { return _timeToFirstValid; }
+        static float countsToLux(uint16_t counts, uint8_t rangeIndex);
+        // log2(lux) in EXPOSURE_FIXED_BITS fixed point from the register values, no float
+        static int32_t countsToLog2Lux(uint16_t counts, uint8_t gain, uint8_t integrationTime);
+        static const lightSensorRange_t &getRange(uint8_t rangeIndex);
+        static uint8_t getRangeCount();
+    private:
+        const lightSensorRange_t &currentRange();
+        static float rangeCountsToLux(uint16_t counts, const lightSensorRange_t &range);
+        void applyRange(uint8_t rangeIndex);
+        void applyFlickerRange(uint8_t flickerRangeIndex);
+        void configure(const lightSensorRange_t &range);
+        uint32_t getSettleMs();
+        uint8_t predictRange(uint16_t counts);
+        Adafruit_VEML7700 *_veml;
+        uint8_t _rangeIndex = 0;
+        uint8_t _flickerRangeIndex = 0;
+        bool _flickerMode = false;
+        bool _powerSave = false;
+        uint32_t _rangeChangedAt = 0;
+        uint32_t _beginAt = 0;
+        uint32_t _timeToFirstValid = 0;
+        uint32_t _rangeChanges = 0;
+        uint16_t _counts = 0;
+        float _lux = 0;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "lux_filter.h"
+
+/*
+  Cheap to call for every sample, history is only dropped when the filter
+  type or length actually changed. Out of range values, e.g. from settings
+  saved by older firmware, fall back to a pass-through filter
+*/
+void LuxFilter::configure(uint8_t type, uint8_t samples) {
+    if (type >= LUX_FILTER_COUNT) {
+        type = LUX_FILTER_NONE;
+    }
+    samples = constrain(samples, 1, LUX_FILTER_WINDOW_MAX);
+
+    if (type == _type && samples == _samples) {
+        return;
+    }
+
+    _type = type;
+    _samples = samples;
+    // Time constant of `samples` sample periods
+    _alpha = lroundf((1.0f - expf(-1.0f / samples)) * EXPOSURE_FIXED_ONE);
+    reset();
+}
+
+void LuxFilter::reset() {
+    _head = 0;
+    _count = 0;
+}
+
+int32_t LuxFilter::update(int32_t log2Lux) {
+    if (_type == LUX_FILTER_NONE) {
+        return log2Lux;
+    }
+
+    if (_type == LUX_FILTER_EMA) {
+        // First sample or a scene change seeds the average instead of ramping to it
+        if (_count == 0 || abs(log2Lux - _ema) > LUX_FILTER_EMA_RESET_STOPS * EXPOSURE_FIXED_ONE) {
+            _ema = log2Lux;
+            _count = 1;
+        } else {
+            _ema += ((int64_t)_alpha * (log2Lux - _ema)) >> EXPOSURE_FIXED_BITS;
+        }
+        return _ema;
+    }
+
+    // Median, evict the oldest sample once the window is full
+    if (_count == _samples) {
+        sortedRemove(_ring[_head]);
+    }
+    sortedInsert(log2Lux);
+
+    _ring[_head] = log2Lux;
+    _head = (_head + 1 < _samples) ? _head + 1 : 0;
+
+    const uint8_t middle = _count / 2;
+    if (_count & 1) {
+        return _sorted[middle];
+    }
+    return (_sorted[middle - 1] + _sorted[middle]) / 2;
+}
+
+// Index of the first sorted entry not less than log2Lux
+uint8_t LuxFilter::sortedFind(int32_t log2Lux) {
+    uint8_t low = 0;
+    uint8_t high = _count;
+
+    while (low < high) {
+        const uint8_t mid = (low + high) / 2;
+        if (_sorted[mid] < log2Lux) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void LuxFilter::sortedRemove(int32_t log2Lux) {
+    const uint8_t index = sortedFind(log2Lux);
+
+    memmove(&_sorted[index], &_sorted[index + 1], (_count - index - 1) * sizeof(int32_t));
+    _count--;
+}
+
+void LuxFilter::sortedInsert(int32_t log2Lux) {
+    const uint8_t index = sortedFind(log2Lux);
+
+    memmove(&_sorted[index + 1], &_sorted[index], (_count - index) * sizeof(int32_t));
+    _sorted[index] = log2Lux;
+    _count++;
+}
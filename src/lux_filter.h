@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef LUX_FILTER_H
+#define LUX_FILTER_H
+
+#include "Arduino.h"
+#include "types.h"
+#include "exposure.h"
+
+// Longest history kept, odd so a full median window has a middle sample
+#define LUX_FILTER_WINDOW_MAX 15
+
+/*
+  EMA restarts from the new sample when it is more than this many stops
+  away from the average, so a scene change shows up at once while flicker
+  and noise well below a stop are still smoothed
+*/
+#define LUX_FILTER_EMA_RESET_STOPS 1
+
+/*
+  Streaming filter between the light sensor and the exposure math, on
+  log2(lux) in EXPOSURE_FIXED_BITS fixed point as countsToLog2Lux returns
+  it, so a filtered sample goes to exposureSolveFixed without float math.
+  The EMA averages stops, the median is the same sample as on lux. History
+  lives in a fixed ring buffer, a sorted copy of the window is kept next to
+  it so the median is a lookup after a binary search insert / remove.
+  EMA is O(1) and needs no history at all
+*/
+class LuxFilter {
+    public:
+        void configure(uint8_t type, uint8_t samples);
+        void reset();
+        int32_t update(int32_t log2Lux);
+        uint8_t getType() { return _type; }
+        uint8_t getSamples() { return _samples; }
+    private:
+        void sortedRemove(int32_t log2Lux);
+        void sortedInsert(int32_t log2Lux);
+        uint8_t sortedFind(int32_t log2Lux);
+        uint8_t _type = LUX_FILTER_NONE;
+        uint8_t _samples = 1;
+        // Fixed point like the samples
+        int32_t _alpha = EXPOSURE_FIXED_ONE;
+        int32_t _ema = 0;
+        int32_t _ring[LUX_FILTER_WINDOW_MAX];
+        int32_t _sorted[LUX_FILTER_WINDOW_MAX];
+        uint8_t _head = 0;
+        uint8_t _count = 0;
+};
+
+#endif
@@ -2,10 +2,25 @@
 #include <Adafruit_VEML7700.h>
 #include "SSD1306.h"
 #include "oled_display.h"
-#include "QmuTactile.h"
 #include "types.h"
 #include <Wire.h>
 #include "eeprom_storage.h"
+#include "measurement.h"
+#include "input.h"
+#include "settings_store.h"
+#include "light_sensor.h"
+#include "lux_filter.h"
+#include "flicker.h"
+#include "measurement_log.h"
+#include "telemetry.h"
+#include "benchmark.h"
+#include "stage_timing.h"
+#include "camera_presets.h"
+#include "measurement_memory.h"
+#include "power_manager.h"
+#include "i2c_arbiter.h"
+#include "calibration.h"
+#include "boot_timing.h"
 
 #define LIGHT_SENSOR_TASK_MS 250
 
@@ -22,30 +37,45 @@
 #define PIN_OLED_SCL 15
 #define PIN_OLED_RST 16
 #define OLED_ADDRESS 0x3c
+#define OLED_RESET_MS 50
 
 #define EEPROM_SIZE 64
 #define EEPROM_IDENT_ADDRESS 0
 #define EEPROM_SETTINGS_ADDRESS 1
 #define EEPROM_IDENT 0x69
 
-QmuTactile buttonMode(PIN_BUTTON_MODE);
-
-QmuTactile buttonUp(PIN_BUTTON_UP);
-QmuTactile buttonDown(PIN_BUTTON_DOWN);
-QmuTactile buttonLeft(PIN_BUTTON_LEFT);
-QmuTactile buttonRight(PIN_BUTTON_RIGHT);
-
-QmuTactile buttonHold(PIN_BUTTON_HOLD);
+// Settings as older firmware saved them to EEPROM, ISO, aperture and shutter in full stops
+typedef struct eepromSettings_s {
+  int8_t isoIndex;
+  int8_t apertureIndex;
+  int8_t shutterIndex;
+  int8_t ndFilterIndex;
+  lightMeterMode_e type;
+  lightMeterCompute_e mode;
+  adjustSetting_e adjustSetting;
+} eepromSettings_t;
+
+#define SERIAL_COMMAND_MAX 16
+
+// In button_e order
+static const uint8_t BUTTON_PINS[BUTTON_COUNT] = {
+  PIN_BUTTON_MODE,
+  PIN_BUTTON_UP,
+  PIN_BUTTON_DOWN,
+  PIN_BUTTON_LEFT,
+  PIN_BUTTON_RIGHT,
+  PIN_BUTTON_HOLD
+};
 
 SSD1306 display(OLED_ADDRESS, PIN_OLED_SDA, PIN_OLED_SCL);
-OledDisplay oledDisplay(&display);
+OledDisplay oledDisplay(&display, &Wire, OLED_ADDRESS);
 Adafruit_VEML7700 veml = Adafruit_VEML7700();
+LightSensor lightSensor(&veml);
+// Sensor task only
+LuxFilter luxFilter;
+FlickerAnalyzer flickerAnalyzer;
 TwoWire I2C1 = TwoWire(0);
-
-String ISO_TABLE[] = {"25", "50", "100", "200", "400", "800", "1600", "3200", "6400", "128K", "256K"};
-String APERTURE_TABLE[] = {"1.0", "1.4", "2", "2.8", "4", "5.6", "8", "11", "16", "22", "32"};
-String SHUTTER_TABLE[] = {"60", "30", "15", "8", "4", "2", "1", "1/2", "1/4", "1/8", "1/15", "1/30", "1/60", "1/125", "1/250", "1/500", "1/1000", "1/2000", "1/4000", "1/8000", "1/16k", "1/32k"};
-String TYPE_TABLE[] = {"Incident", "Reflected"};
+PowerManager powerManager(&oledDisplay, BUTTON_PINS, BUTTON_COUNT);
 
 /*
   It's in order of:
@@ -53,111 +83,235 @@ String TYPE_TABLE[] = {"Incident", "Reflected"};
   LIGHT_METER_MODE_SHUTTER
   LIGHT_METER_MODE_ISO
   LIGHT_METER_MODE_ND
+  LIGHT_METER_MODE_FLICKER
 
   Used to determine which setting to change when left/ right buttons pressed
 */
-static const adjustSetting_e ADJUST_SETTING_MATRIX[4][3] = {
+static const adjustSetting_e ADJUST_SETTING_MATRIX[LIGHT_METER_MODE_COUNT][3] = {
   {ADJUST_SETTING_ISO,     ADJUST_SETTING_SHUTTER,  ADJUST_SETTING_ND_FILTER},
   {ADJUST_SETTING_ISO,     ADJUST_SETTING_APERTURE, ADJUST_SETTING_ND_FILTER},
   {ADJUST_SETTING_SHUTTER, ADJUST_SETTING_APERTURE, ADJUST_SETTING_ND_FILTER},
-  {ADJUST_SETTING_ISO,     ADJUST_SETTING_APERTURE,  ADJUST_SETTING_SHUTTER}
+  {ADJUST_SETTING_ISO,     ADJUST_SETTING_APERTURE,  ADJUST_SETTING_SHUTTER},
+  {ADJUST_SETTING_SHUTTER, ADJUST_SETTING_SHUTTER,  ADJUST_SETTING_SHUTTER}
 };
 
 static const oledPages_e modeToPageMapping[LIGHT_METER_MODE_COUNT] = {
   OLED_PAGE_APERTURE,
   OLED_PAGE_SHUTTER,
   OLED_PAGE_ISO,
-  OLED_PAGE_ND
+  OLED_PAGE_ND,
+  OLED_PAGE_FLICKER
 };
 
+// Owned by the UI loop on core 1, the sensor task only sees settingsSnapshot
 settings_t settings;
 
+SeqLock<measurement_t> measurementSnapshot;
+SeqLock<settings_t> settingsSnapshot;
+SeqLock<cameraPresets_t> presetsSnapshot;
+
+SettingsStore settingsStore;
+CameraPresets cameraPresets;
+MeasurementMemory measurementMemory;
+MeasurementLog measurementLog;
+Telemetry telemetry;
+Benchmark benchmark;
+StageTiming stageTiming;
+I2cArbiter i2cArbiter;
+Calibration calibration;
+BootTiming bootTiming;
+
 TaskHandle_t lightSensorTask;
 
-void lightSensorTaskHandler(void *pvParameters)
+/*
+  Single sensor sample: read and filter lux, compute EV and the output value for the
+  current mode. Kept separate from the task loop so it can be stepped on the
+  native host build. Returns the time until the next sample is due
+*/
+uint32_t lightSensorUpdate()
 {
-  portTickType xLastWakeTime;
-  const portTickType xPeriod = LIGHT_SENSOR_TASK_MS / portTICK_PERIOD_MS;
-  xLastWakeTime = xTaskGetTickCount();
+  settings_t sampleSettings;
+  cameraPresets_t samplePresets;
+  measurement_t measurement = {};
 
-  for (;;)
-  {
-    lux = veml.readLux(VEML_LUX_AUTO);
+  settingsSnapshot.read(&sampleSettings);
+  presetsSnapshot.read(&samplePresets);
 
-    reflectedEv = log2(lux) + 3;
-    incidentEv = log2(lux / 2.5f);
+  const bool flickerMode = sampleSettings.mode == LIGHT_METER_MODE_FLICKER;
 
-    if (settings.type == LIGHT_METER_TYPE_REFLECTED)
-    {
-      ev = reflectedEv;
-    } else {
-      ev = incidentEv;
+  if (flickerMode != lightSensor.isFlickerMode()) {
+    lightSensor.setFlickerMode(flickerMode);
+    flickerAnalyzer.reset();
+  }
+
+  // Display off: the VEML7700 spaces out its conversions and sampling follows them, flicker needs every sample
+  lightSensor.setPowerSave(powerManager.getState() == POWER_STATE_OFF && !flickerMode);
+  powerManager.setSensorPowerSave(lightSensor.isPowerSave());
+
+  const uint32_t period = flickerMode ? FLICKER_SAMPLE_PERIOD_MS
+                                      : (lightSensor.isPowerSave() ? lightSensor.getRefreshMs() : LIGHT_SENSOR_TASK_MS);
+
+  const uint32_t readStart = StageTiming::start();
+  const bool updated = lightSensor.update();
+  stageTiming.stop(TIMING_STAGE_SENSOR_READ, readStart);
+
+  // Nothing new while a range change is settling, sampled again as soon as it settled
+  if (!updated) {
+    // Flicker samples have to be evenly spaced, start the buffer over
+    flickerAnalyzer.reset();
+    return constrain(lightSensor.getSettleRemainingMs(), 1, period);
+  }
+
+  if (flickerMode) {
+    // Published once per full buffer, the mean level stands in for the lux sample
+    if (!flickerAnalyzer.addSample(lightSensor.getCounts())) {
+      return period;
     }
+    flickerAnalyzer.analyze(&measurement.flicker);
+
+    measurement.counts = measurement.flicker.meanCounts;
+    measurement.rawLux = lightSensor.getLuxForCounts(measurement.counts);
+  } else {
+    measurement.counts = lightSensor.getCounts();
+    measurement.rawLux = lightSensor.getLux();
+  }
 
-    // effective EV is the EV at ISO 100 + isoIndex where 0 is ISO100, 1 is ISO200, 2 is ISO400, etc.
-    ev += settings.isoIndex;
+  measurement.gain = lightSensor.getGain();
+  measurement.integrationTime = lightSensor.getIntegrationTime();
 
-    // Substract the effect of used ND filter
-    ev -= settings.ndFilterIndex;
+  // Filtered in the log2 domain the solver works in, flicker buffers are an average already
+  const int32_t log2Lux = LightSensor::countsToLog2Lux(measurement.counts, measurement.gain, measurement.integrationTime);
+  if (flickerMode) {
+    measurement.log2Lux = log2Lux;
+    measurement.lux = measurement.rawLux;
+  } else {
+    luxFilter.configure(sampleSettings.luxFilter, sampleSettings.luxFilterSamples);
+    measurement.log2Lux = luxFilter.update(log2Lux);
+    measurement.lux = (measurement.log2Lux == log2Lux) ? measurement.rawLux
+                                                       : measurement.rawLux * exp2f((float)(measurement.log2Lux - log2Lux) / EXPOSURE_FIXED_ONE);
+  }
 
-    if (settings.mode == LIGHT_METER_MODE_APERTURE) {
+  const uint32_t solveStart = StageTiming::start();
+  measurementSolve(&measurement, sampleSettings, samplePresets);
+  stageTiming.stop(TIMING_STAGE_EV_COMPUTE, solveStart);
+  measurementSnapshot.write(measurement);
+  bootTiming.mark(BOOT_PHASE_FIRST_EV);
+  measurementLog.append(measurement);
 
-      const float shutter = 1.0f / pow(2, settings.shutterIndex);
+  // Wakes the UI loop to redraw
+  inputPostMeasurement();
 
-      // Store computed aperture
-      outputValue = sqrt(shutter * pow(2, ev));
-    } else if (settings.mode == LIGHT_METER_MODE_SHUTTER){
-      // Compute shutter time (seconds) from EV and selected aperture
-      // Equation derivation from aperture mode: f^2 = shutter * 2^ev
-      // => shutter = f^2 / 2^ev. With full-stop aperture indexing,
-      // f^2 equals 2^(apertureIndex).
-      const float apertureSquared = powf(2.0f, settings.apertureIndex);
-      const float shutter = apertureSquared / powf(2.0f, ev);
+  return period;
+}
 
-      // Store computed shutter (seconds)
-      outputValue = shutter;
-    } else {
-      // TODO This is ISO case
-      //  ev = incidentEv;
-    }
+/*
+  Scheduled on millis(), which keeps counting through light sleep while
+  the tick count does not. The UI loop notifies the task after a light
+  sleep, it would wake a whole sleep too late otherwise
+*/
+void lightSensorTaskHandler(void *pvParameters)
+{
+  (void)pvParameters;
 
-    oledDisplay.forceDisplay();
+  uint32_t nextSampleAt = millis();
+
+  for (;;)
+  {
+    const int32_t wait = (int32_t)(nextSampleAt - millis());
 
-    // Put task to sleep
-    vTaskDelayUntil(&xLastWakeTime, xPeriod);
+    if (wait > 0) {
+      ulTaskNotifyTake(pdTRUE, wait / portTICK_PERIOD_MS);
+      continue;
+    }
+
+    nextSampleAt += lightSensorUpdate();
+    // Late samples are dropped rather than caught up in a burst
+    if ((int32_t)(millis() - nextSampleAt) > 0) {
+      nextSampleAt = millis();
+    }
+    powerManager.setNextSampleAt(nextSampleAt);
   }
 
   vTaskDelete(NULL);
 }
 
+/*
+  Boot starts what takes time on its own first and does the rest while it
+  runs: the VEML7700 integrates from the first lines on and the OLED reset
+  pulse is held while settings and storage load. The display driver
+  restarts the bus in init(), so the sensor task only starts after it, still
+  well inside the first integration
+*/
 void setup() {
-
-  while (!EEPROM.begin(EEPROM_SIZE)) {
-    true;
+  // Setup I2C, OLED held in reset meanwhile
+  pinMode(PIN_OLED_RST, OUTPUT);
+  digitalWrite(PIN_OLED_RST, LOW); // set GPIO16 low to reset OLED
+  const uint32_t oledResetAt = millis();
+  Wire.begin(PIN_OLED_SDA, PIN_OLED_SCL);
+  i2cArbiter.begin(&Wire);
+
+  const bool sensorFound = lightSensor.begin();
+  bootTiming.mark(BOOT_PHASE_SENSOR_STARTED);
+
+  if (!settingsStore.begin(&settings)) {
+    // Empty journal, take over settings saved to EEPROM by older firmware
+    if (EEPROM.begin(EEPROM_SIZE) && EEPROM.read(EEPROM_IDENT_ADDRESS) == EEPROM_IDENT) {
+      eepromSettings_t saved;
+      EEPROM_readAnything(EEPROM_SETTINGS_ADDRESS, saved);
+
+      // Fields older firmware did not have keep their defaults, the exposure stays the same in thirds
+      settings = settings_t();
+      settings.isoIndex = stopConvertIndex(saved.isoIndex, STOP_INCREMENT_FULL, settings.stopIncrement);
+      settings.apertureIndex = stopConvertIndex(saved.apertureIndex, STOP_INCREMENT_FULL, settings.stopIncrement);
+      settings.shutterIndex = stopConvertIndex(saved.shutterIndex, STOP_INCREMENT_FULL, settings.stopIncrement);
+      settings.ndFilterIndex = saved.ndFilterIndex;
+      settings.type = saved.type;
+      settings.mode = saved.mode;
+      settings.adjustSetting = saved.adjustSetting;
+    }
+    settingsStore.update(settings);
+    settingsStore.flush();
   }
 
-  if (EEPROM.read(EEPROM_IDENT_ADDRESS) == EEPROM_IDENT) {
-    EEPROM_readAnything(EEPROM_SETTINGS_ADDRESS, settings);
-  } else {
-    EEPROM.write(EEPROM_IDENT_ADDRESS, EEPROM_IDENT);
-    EEPROM_writeAnything(EEPROM_SETTINGS_ADDRESS, settings);
-    EEPROM.commit();
+  if (settings.stopIncrement >= STOP_INCREMENT_COUNT) {
+    settings.stopIncrement = STOP_INCREMENT_FULL;
   }
 
+  settingsSnapshot.write(settings);
+  bootTiming.mark(BOOT_PHASE_SETTINGS_LOADED);
+
+  // Telemetry frames are queued here and drained by the UART interrupt
+  Serial.setTxBufferSize(TELEMETRY_TX_BUFFER_SIZE);
   Serial.begin(115200);
 
-  // Setup I2C OLED
-  pinMode(PIN_OLED_RST, OUTPUT);
-  digitalWrite(PIN_OLED_RST, LOW); // set GPIO16 low to reset OLED
-  delay(50);
+  // Runs without a log if the filesystem can't be mounted
+  measurementLog.begin();
+  // No presets stored yet or no filesystem, all slots start empty
+  cameraPresets.begin();
+  presetsSnapshot.write(cameraPresets.get());
+  // Uncalibrated devices meter with the nominal sensor model
+  calibration.begin();
+  bootTiming.mark(BOOT_PHASE_STORAGE_READY);
+
+  //Init all buttons
+  inputBegin(BUTTON_PINS);
+
+  // Only what is left of the reset pulse
+  const uint32_t oledResetElapsed = millis() - oledResetAt;
+  if (oledResetElapsed < OLED_RESET_MS) {
+    delay(OLED_RESET_MS - oledResetElapsed);
+  }
   digitalWrite(PIN_OLED_RST, HIGH); // while OLED is running, must set GPIO16 to high
-  Wire.begin(PIN_OLED_SDA, PIN_OLED_SCL);
 
   oledDisplay.init();
+  // The display driver raised the bus clock
+  i2cArbiter.refreshClock();
+  powerManager.begin();
   oledDisplay.setPage(modeToPageMapping[settings.mode]);
   oledDisplay.setOnlyForcedDisplay(true);
+  bootTiming.mark(BOOT_PHASE_DISPLAY_READY);
 
-  if (!veml.begin()) {
+  if (!sensorFound) {
     oledDisplay.setPage(OLED_PAGE_ERROR);
     oledDisplay.forceDisplay();
     delay(1000);
@@ -165,15 +319,6 @@ void setup() {
       ;
   }
 
-  //Init all buttons
-  buttonMode.start();
-  buttonUp.start();
-  buttonDown.start();
-  buttonLeft.start();
-  buttonRight.start();
-
-  buttonHold.start();
-
   xTaskCreatePinnedToCore(
       lightSensorTaskHandler, /* Function to implement the task */
       "lightSensorTask",      /* Name of the task */
@@ -182,91 +327,171 @@ void setup() {
       0,                      /* Priority of the task */
       &lightSensorTask,       /* Task handle. */
       0);
+  bootTiming.mark(BOOT_PHASE_TASK_STARTED);
 }
 
-float lux;
-float ev;
-float evIso;
-float reflectedEv;
-float incidentEv;
-
-float outputValue = 0;
-
 //Index variable used to determine which property is editable at the moment
 int8_t propertyChangeIndex = 0;
 
-void loop()
+// Hands changed settings to the sensor task and schedules a write-behind save
+void settingsChanged()
+{
+  settingsSnapshot.write(settings);
+  settingsStore.update(settings);
+}
+
+void handleButtonEvent(const inputEvent_t &event)
 {
+  // Long press Hold shows the hidden diagnostics page and back
+  if (event.button == BUTTON_HOLD && event.press == INPUT_PRESS_LONG) {
+    if (oledDisplay.getPage() == OLED_PAGE_DIAGNOSTICS) {
+      oledDisplay.setPage(modeToPageMapping[settings.mode]);
+    } else {
+      oledDisplay.setPage(OLED_PAGE_DIAGNOSTICS);
+    }
+    oledDisplay.forceDisplay();
+    return;
+  }
 
-  buttonMode.loop();
+  // Settings can't be seen there, don't change them blindly
+  if (oledDisplay.getPage() == OLED_PAGE_DIAGNOSTICS) {
+    return;
+  }
 
-  buttonUp.loop();
-  buttonDown.loop();
-  buttonLeft.loop();
-  buttonRight.loop();
-  
-  buttonHold.loop();
+  // Short press Hold freezes the current reading into the memory and shows it
+  if (event.button == BUTTON_HOLD && event.press == INPUT_PRESS_SHORT) {
+    measurement_t measurement;
 
-  if (buttonMode.getState() == TACTILE_STATE_LONG_PRESS) {
+    measurementSnapshot.read(&measurement);
+    measurementResolve(&measurement, settings, cameraPresets.get());
 
-      if (settings.mode == LIGHT_METER_MODE_APERTURE) {
-          settings.mode = LIGHT_METER_MODE_SHUTTER;
-      } else {
-          settings.mode = LIGHT_METER_MODE_APERTURE;
+    // At ISO 100 without filter, ratios between readings don't depend on the settings
+    const float meteredEv = (settings.type == LIGHT_METER_TYPE_REFLECTED) ? measurement.reflectedEv : measurement.incidentEv;
+    measurementMemory.push(lroundf(meteredEv * 100), millis());
+
+    oledDisplay.setPage(OLED_PAGE_MEMORY);
+    oledDisplay.forceDisplay();
+    return;
+  }
+
+  // Short press Mode shows every camera preset, from the presets and memory pages it goes back
+  if (event.button == BUTTON_MODE && event.press == INPUT_PRESS_SHORT) {
+    if (oledDisplay.getPage() == OLED_PAGE_PRESETS || oledDisplay.getPage() == OLED_PAGE_MEMORY) {
+      oledDisplay.setPage(modeToPageMapping[settings.mode]);
+    } else {
+      oledDisplay.setPage(OLED_PAGE_PRESETS);
+    }
+    oledDisplay.forceDisplay();
+    return;
+  }
+
+  // On the memory page Left and Right browse, Up marks the key light and Down the fill light
+  if (oledDisplay.getPage() == OLED_PAGE_MEMORY) {
+    if (event.press == INPUT_PRESS_SHORT) {
+      if (event.button == BUTTON_LEFT) {
+        measurementMemory.moveCursor(-1);
+      } else if (event.button == BUTTON_RIGHT) {
+        measurementMemory.moveCursor(1);
+      } else if (event.button == BUTTON_UP) {
+        measurementMemory.markKey();
+      } else if (event.button == BUTTON_DOWN) {
+        measurementMemory.markFill();
       }
+      oledDisplay.forceDisplay();
+    }
+    return;
+  }
+
+  // On the presets page Left and Right switch the active preset, long press Down stores the settings in it
+  if (oledDisplay.getPage() == OLED_PAGE_PRESETS) {
+    if ((event.button == BUTTON_LEFT || event.button == BUTTON_RIGHT) && event.press == INPUT_PRESS_SHORT) {
+      const uint8_t step = (event.button == BUTTON_RIGHT) ? 1 : CAMERA_PRESET_COUNT - 1;
+
+      cameraPresets.select(cameraPresets.getActive() + step, &settings);
+      // Switching is not a settings change, only the sensor task has to know
+      settingsSnapshot.write(settings);
+      oledDisplay.forceDisplay();
+    } else if (event.button == BUTTON_DOWN && event.press == INPUT_PRESS_LONG) {
+      cameraPresets.store(settings);
+      presetsSnapshot.write(cameraPresets.get());
+      oledDisplay.forceDisplay();
+    }
+    return;
+  }
+
+  if (event.button == BUTTON_MODE && event.press == INPUT_PRESS_LONG) {
+
+      // Aperture, shutter, ISO, ND, flicker and around again
+      settings.mode = (lightMeterCompute_e)((settings.mode + 1) % LIGHT_METER_MODE_COUNT);
 
       oledDisplay.setPage(modeToPageMapping[settings.mode]);
       propertyChangeIndex = 0;
       settings.adjustSetting = ADJUST_SETTING_MATRIX[settings.mode][propertyChangeIndex];
+      settingsChanged();
 
       oledDisplay.forceDisplay();
   }
 
+  // Long press Up cycles full, 1/2 and 1/3 stops, the settings keep their exposure
+  if (event.button == BUTTON_UP && event.press == INPUT_PRESS_LONG) {
+    const uint8_t increment = (settings.stopIncrement + 1) % STOP_INCREMENT_COUNT;
+
+    settings.isoIndex = stopConvertIndex(settings.isoIndex, settings.stopIncrement, increment);
+    settings.apertureIndex = stopConvertIndex(settings.apertureIndex, settings.stopIncrement, increment);
+    settings.shutterIndex = stopConvertIndex(settings.shutterIndex, settings.stopIncrement, increment);
+    settings.stopIncrement = increment;
+    settingsChanged();
+
+    oledDisplay.forceDisplay();
+  }
+
   // Button logic
 
   //Up and down buttons select a property to change based on current mode
-  if (buttonUp.getState() == TACTILE_STATE_SHORT_PRESS) {
+  if (event.button == BUTTON_UP && event.press == INPUT_PRESS_SHORT) {
     propertyChangeIndex--;
     if (propertyChangeIndex < 0) {
       propertyChangeIndex = 2;
     }
     
     settings.adjustSetting = ADJUST_SETTING_MATRIX[settings.mode][propertyChangeIndex];
+    settingsChanged();
     
     oledDisplay.forceDisplay();
   }
-  if (buttonDown.getState() == TACTILE_STATE_SHORT_PRESS) {
+  if (event.button == BUTTON_DOWN && event.press == INPUT_PRESS_SHORT) {
     propertyChangeIndex++;
     if (propertyChangeIndex > 2) {
       propertyChangeIndex = 0;
     }
     
     settings.adjustSetting = ADJUST_SETTING_MATRIX[settings.mode][propertyChangeIndex];
+    settingsChanged();
 
     oledDisplay.forceDisplay();
   }
 
   //Left and right buttons change the selected property
-  if (buttonLeft.getState() == TACTILE_STATE_SHORT_PRESS) {
+  if (event.button == BUTTON_LEFT && event.press == INPUT_PRESS_SHORT) {
     if (settings.adjustSetting == ADJUST_SETTING_APERTURE) {
 
       settings.apertureIndex--;
 
-      if (settings.apertureIndex < 0) {
-        settings.apertureIndex = APERTURE_INDEX_MIN;
+      if (settings.apertureIndex < stopSeries(STOP_QUANTITY_APERTURE, settings.stopIncrement).minIndex) {
+        settings.apertureIndex = stopSeries(STOP_QUANTITY_APERTURE, settings.stopIncrement).minIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_ISO) {
       settings.isoIndex--;
 
-      if (settings.isoIndex < ISO_INDEX_MIN) {
-        settings.isoIndex = ISO_INDEX_MIN;
+      if (settings.isoIndex < stopSeries(STOP_QUANTITY_ISO, settings.stopIncrement).minIndex) {
+        settings.isoIndex = stopSeries(STOP_QUANTITY_ISO, settings.stopIncrement).minIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_SHUTTER) {
 
       settings.shutterIndex--;
 
-      if (settings.shutterIndex < SHUTTER_INDEX_MIN) {
-        settings.shutterIndex = SHUTTER_INDEX_MIN;
+      if (settings.shutterIndex < stopSeries(STOP_QUANTITY_SHUTTER, settings.stopIncrement).minIndex) {
+        settings.shutterIndex = stopSeries(STOP_QUANTITY_SHUTTER, settings.stopIncrement).minIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_TYPE) {
 
@@ -284,34 +509,33 @@ void loop()
       }
     }
     
+    settingsChanged();
     oledDisplay.forceDisplay();
-    EEPROM_writeAnything(EEPROM_SETTINGS_ADDRESS, settings);
-    EEPROM.commit();
   }
 
-  if (buttonRight.getState() == TACTILE_STATE_SHORT_PRESS)
+  if (event.button == BUTTON_RIGHT && event.press == INPUT_PRESS_SHORT)
   {
     if (settings.adjustSetting == ADJUST_SETTING_APERTURE) {
 
       settings.apertureIndex++;
 
-      if (settings.apertureIndex > APERTURE_INDEX_MAX)
+      if (settings.apertureIndex > stopSeries(STOP_QUANTITY_APERTURE, settings.stopIncrement).maxIndex)
       {
-        settings.apertureIndex = APERTURE_INDEX_MAX;
+        settings.apertureIndex = stopSeries(STOP_QUANTITY_APERTURE, settings.stopIncrement).maxIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_ISO) {
       settings.isoIndex++;
 
-      if (settings.isoIndex > ISO_INDEX_MAX)
+      if (settings.isoIndex > stopSeries(STOP_QUANTITY_ISO, settings.stopIncrement).maxIndex)
       {
-        settings.isoIndex = ISO_INDEX_MAX;
+        settings.isoIndex = stopSeries(STOP_QUANTITY_ISO, settings.stopIncrement).maxIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_SHUTTER) {
       settings.shutterIndex++;
 
-      if (settings.shutterIndex > SHUTTER_INDEX_MAX)
+      if (settings.shutterIndex > stopSeries(STOP_QUANTITY_SHUTTER, settings.stopIncrement).maxIndex)
       {
-        settings.shutterIndex = SHUTTER_INDEX_MAX;
+        settings.shutterIndex = stopSeries(STOP_QUANTITY_SHUTTER, settings.stopIncrement).maxIndex;
       }
     } else if (settings.adjustSetting == ADJUST_SETTING_TYPE) {
 
@@ -333,17 +557,175 @@ void loop()
       }
     }
 
+    settingsChanged();
     oledDisplay.forceDisplay();
-    EEPROM_writeAnything(EEPROM_SETTINGS_ADDRESS, settings);
-    EEPROM.commit();
   }
+}
+
+void printDisplayStats()
+{
+  char line[64];
+
+  snprintf(line, sizeof(line), "display rendered=%lu skipped=%lu\n",
+           (unsigned long)oledDisplay.getRenderedFrames(), (unsigned long)oledDisplay.getSkippedFrames());
+  Serial.print(line);
+}
+
+/*
+  Calibration point from the last sample against a reference meter reading
+  of the same light, in EV at ISO 100
+*/
+void addCalibrationPoint(lightMeterMode_e type, const char *referenceEv)
+{
+  measurement_t measurement;
+  calibrationPoint_t point;
+
+  measurementSnapshot.read(&measurement);
+
+  point.counts = measurement.counts;
+  point.referenceEvHundredths = lroundf(atof(referenceEv) * 100);
+  point.type = type;
+  point.gain = measurement.gain;
+  point.integrationTime = measurement.integrationTime;
+
+  if (!calibration.addPoint(point)) {
+    Serial.print("calibration rejected\n");
+  }
+}
+
+/*
+  Filter between the sensor and the exposure math, n for none, e for EMA or m
+  for median, followed by its length in samples. Saved with the settings,
+  the sensor task picks it up with its next sample
+*/
+void setLuxFilter(const char *args)
+{
+  static const char LUX_FILTER_CODES[LUX_FILTER_COUNT] = {'n', 'e', 'm'};
+  static const char *const LUX_FILTER_NAMES[LUX_FILTER_COUNT] = {"none", "ema", "median"};
+  char line[64];
 
-  // static uint32_t nextSerialUpdate = 0;
-  // if (millis() > nextSerialUpdate) {
-  //     nextSerialUpdate = millis() + 100;
-  //     Serial.print("reflected: "); Serial.println(reflectedEv);
-  //     Serial.print("incident: "); Serial.println(incidentEv);
-  // }
+  if (args[0] != '\0') {
+    const char *code = (const char *)memchr(LUX_FILTER_CODES, args[0], LUX_FILTER_COUNT);
+    const int samples = (args[1] != '\0') ? atoi(args + 1) : settings.luxFilterSamples;
+
+    // The median keeps its window in a fixed ring buffer
+    if (code == nullptr || samples < 1 || samples > LUX_FILTER_WINDOW_MAX) {
+      Serial.print("lux_filter rejected\n");
+    } else {
+      settings.luxFilter = code - LUX_FILTER_CODES;
+      settings.luxFilterSamples = samples;
+      settingsChanged();
+    }
+  }
+
+  const uint8_t type = (settings.luxFilter < LUX_FILTER_COUNT) ? settings.luxFilter : (uint8_t)LUX_FILTER_NONE;
+  snprintf(line, sizeof(line), "lux_filter type=%s samples=%u\n", LUX_FILTER_NAMES[type], settings.luxFilterSamples);
+  Serial.print(line);
+}
+
+/*
+  Serial commands, one per line:
+  d       stream the measurement log
+  b       run the benchmarks, results are printed as key=value lines
+  s       print the stage timing histograms, display frame counters, I2C bus stats and boot phases
+  p       print the energy model: duty cycle of every load and battery life
+  t<hz>   binary telemetry at up to <hz> frames per second, t0 stops it
+  c       print the calibration points
+  ci<ev>  calibration point, a reference incident meter reads <ev> at ISO 100 where the meter is now
+  cr<ev>  the same for a reflected reading
+  cx      delete every calibration point
+  f<t><n> lux filter, <t> n (none), e (EMA) or m (median) over <n> samples, 1 to 15; f prints it
+*/
+void handleSerialCommand(const char *command)
+{
+  if (strcmp(command, "d") == 0) {
+    measurementLog.startDump();
+  } else if (strcmp(command, "b") == 0) {
+    benchmark.run();
+  } else if (strcmp(command, "s") == 0) {
+    stageTiming.print();
+    printDisplayStats();
+    i2cArbiter.print();
+    bootTiming.print();
+  } else if (strcmp(command, "p") == 0) {
+    powerManager.print();
+  } else if (command[0] == 't') {
+    telemetry.setRate(constrain(atoi(command + 1), 0, TELEMETRY_RATE_MAX_HZ));
+  } else if (command[0] == 'c') {
+    if (command[1] == 'i') {
+      addCalibrationPoint(LIGHT_METER_TYPE_INCIDENT, command + 2);
+    } else if (command[1] == 'r') {
+      addCalibrationPoint(LIGHT_METER_TYPE_REFLECTED, command + 2);
+    } else if (command[1] == 'x') {
+      calibration.clear();
+    }
+    calibration.print();
+  } else if (command[0] == 'f') {
+    setLuxFilter(command + 1);
+  }
+}
+
+void serialCommandLoop()
+{
+  static char command[SERIAL_COMMAND_MAX];
+  static uint8_t length = 0;
+
+  while (Serial.available() > 0) {
+    const char c = Serial.read();
+
+    if (c == '\n' || c == '\r') {
+      command[length] = '\0';
+      if (length > 0) {
+        handleSerialCommand(command);
+      }
+      length = 0;
+    } else if (length < SERIAL_COMMAND_MAX - 1) {
+      command[length++] = c;
+    }
+  }
+}
+
+void loop()
+{
+  inputEvent_t event;
+  bool measured = false;
+
+  // Blocks until a button event or a new measurement arrives
+  if (inputWaitEvent(&event)) {
+    if (event.type == INPUT_EVENT_MEASUREMENT) {
+      oledDisplay.forceDisplay();
+      measured = true;
+    } else if (event.type == INPUT_EVENT_BUTTON && !powerManager.activity()) {
+      // A press that only woke the display does nothing else
+      handleButtonEvent(event);
+    }
+  }
+
+  inputPoll();
+  settingsStore.loop();
+
+  serialCommandLoop();
+  measurementLog.loop();
+
+  // The log dump owns the port until it is done
+  if (!measurementLog.isDumping()) {
+    telemetry.loop();
+  }
+
+  // Nothing is left in RAM only once the display is off
+  if (powerManager.loop()) {
+    settingsStore.flush();
+    measurementLog.requestFlush();
+  }
 
   oledDisplay.loop();
+  if (measured) {
+    bootTiming.mark(BOOT_PHASE_FIRST_FRAME);
+  }
+
+  // Sleeps until the next sample or a button, Serial can't receive meanwhile
+  if (inputIsIdle() && telemetry.getRate() == 0 && !measurementLog.isDumping() && powerManager.lightSleep()) {
+    inputResume();
+    xTaskNotifyGive(lightSensorTask);
+  }
 }
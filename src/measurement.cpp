@@ -0,0 +1,29 @@
+#include "measurement.h"
+#include "exposure.h"
+
+void measurementSolve(measurement_t *measurement, const settings_t &settings, const cameraPresets_t &presets) {
+    exposureResult_t exposure;
+
+    exposureSolveFixed(measurement->log2Lux, settings, &exposure);
+
+    measurement->reflectedEv = exposure.reflectedEv;
+    measurement->incidentEv = exposure.incidentEv;
+    measurement->ev = exposure.ev;
+    measurement->outputValue = exposure.outputSteps;
+    measurement->settings = settings;
+
+    exposureSolvePresets(exposure, settings.type, presets, measurement->presetOutput);
+    measurement->presets = presets;
+}
+
+/*
+  Settings or presets changed on the UI side since the sample was solved,
+  solve the same log2(lux) again so values and settings on screen always belong
+  together
+*/
+void measurementResolve(measurement_t *measurement, const settings_t &settings, const cameraPresets_t &presets) {
+    if (memcmp(&measurement->settings, &settings, sizeof(settings_t)) != 0 ||
+        memcmp(&measurement->presets, &presets, sizeof(cameraPresets_t)) != 0) {
+        measurementSolve(measurement, settings, presets);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include "Arduino.h"
+#include "types.h"
+#include "seqlock.h"
+#include "flicker.h"
+#include "camera_presets.h"
+
+/*
+  One light sensor sample with everything derived from it and the settings
+  it was solved for, published as a whole from the sensor task (core 0)
+*/
+typedef struct measurement_s {
+    // Filtered log2(lux), EXPOSURE_FIXED_BITS fixed point, everything below is solved from it
+    int32_t log2Lux;
+    // Filtered and raw lux, for display and logging only
+    float lux;
+    float rawLux;
+    // Raw VEML7700 reading the lux value came from
+    uint16_t counts;
+    uint8_t gain;
+    uint8_t integrationTime;
+    float reflectedEv;
+    float incidentEv;
+    float ev;
+    // Solved Av, Tv, ISO or ND term in steps of the stop increment, depending on the mode
+    int16_t outputValue;
+    // Only filled in flicker mode, once per sample buffer
+    flickerResult_t flicker;
+    settings_t settings;
+    // Av of every preset in steps of presets.increment, solved in the same pass
+    int16_t presetOutput[CAMERA_PRESET_COUNT];
+    cameraPresets_t presets;
+} measurement_t;
+
+// Sensor task -> UI
+extern SeqLock<measurement_t> measurementSnapshot;
+// UI -> sensor task
+extern SeqLock<settings_t> settingsSnapshot;
+extern SeqLock<cameraPresets_t> presetsSnapshot;
+
+void measurementSolve(measurement_t *measurement, const settings_t &settings, const cameraPresets_t &presets);
+void measurementResolve(measurement_t *measurement, const settings_t &settings, const cameraPresets_t &presets);
+
+#endif
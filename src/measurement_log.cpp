@@ -0,0 +1,260 @@
+#include "measurement_log.h"
+#include <Adafruit_VEML7700.h>
+#include "byte_order.h"
+
+// Give up waiting for the sensor task to close its page after this long
+#define MEASUREMENT_LOG_FLUSH_TIMEOUT_MS 1000
+
+// VEML7700 integration time register values, the record stores the index
+static const uint8_t INTEGRATION_TIME_CODES[] = {
+    VEML7700_IT_25MS, VEML7700_IT_50MS, VEML7700_IT_100MS, VEML7700_IT_200MS, VEML7700_IT_400MS, VEML7700_IT_800MS
+};
+
+static const uint16_t INTEGRATION_TIME_MS[] = {25, 50, 100, 200, 400, 800};
+
+#define INTEGRATION_TIME_COUNT (sizeof(INTEGRATION_TIME_CODES) / sizeof(INTEGRATION_TIME_CODES[0]))
+
+static uint8_t integrationTimeIndex(uint8_t code) {
+    for (uint8_t i = 0; i < INTEGRATION_TIME_COUNT; i++) {
+        if (INTEGRATION_TIME_CODES[i] == code) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Only what changes the readout, adjustSetting and filter choice are not logged
+static bool sameLoggedSettings(const settings_t &a, const settings_t &b) {
+    return a.isoIndex == b.isoIndex && a.apertureIndex == b.apertureIndex && a.shutterIndex == b.shutterIndex &&
+           a.ndFilterIndex == b.ndFilterIndex && a.type == b.type && a.mode == b.mode &&
+           a.stopIncrement == b.stopIncrement;
+}
+
+static void encodeKeyframe(uint8_t *record, uint32_t timestamp, const settings_t &settings, bool boot) {
+    record[0] = MEASUREMENT_LOG_FLAG_KEYFRAME | (settings.mode & 0x07) | ((settings.type & 0x01) << 3) |
+                (boot ? MEASUREMENT_LOG_FLAG_BOOT : 0);
+    putLe(record + 1, timestamp, 4);
+
+    // Indexes are counted from the start of their series, 1/3 stops need 6 bits
+    const uint8_t increment = settings.stopIncrement;
+    const uint32_t packed = ((settings.isoIndex - stopSeries(STOP_QUANTITY_ISO, increment).minIndex) & 0x3F) |
+                            (((settings.shutterIndex - stopSeries(STOP_QUANTITY_SHUTTER, increment).minIndex) & 0x3F) << 6) |
+                            (((settings.apertureIndex - stopSeries(STOP_QUANTITY_APERTURE, increment).minIndex) & 0x3F) << 12) |
+                            ((settings.ndFilterIndex & 0x0F) << 18) |
+                            ((increment & 0x03) << 22);
+    putLe(record + 5, packed, 3);
+}
+
+static void encodeSample(uint8_t *record, uint32_t delta, const measurement_t &measurement) {
+    const int32_t evHundredths = constrain(lroundf(measurement.ev * 100), INT16_MIN, INT16_MAX);
+
+    record[0] = (measurement.gain & 0x03) | (integrationTimeIndex(measurement.integrationTime) << 2);
+    putLe(record + 1, delta, 3);
+    putLe(record + 4, measurement.counts, 2);
+    putLe(record + 6, (uint16_t)evHundredths, 2);
+}
+
+uint8_t MeasurementLog::decodeRecord(const uint8_t *record, measurementLogEntry_t *entry) {
+    bool empty = true;
+    for (uint8_t i = 0; i < MEASUREMENT_LOG_RECORD_SIZE; i++) {
+        empty = empty && record[i] == 0xFF;
+    }
+    if (empty) {
+        return MEASUREMENT_LOG_RECORD_EMPTY;
+    }
+
+    if (record[0] & MEASUREMENT_LOG_FLAG_KEYFRAME) {
+        const uint32_t packed = getLe(record + 5, 3);
+        const uint8_t increment = (packed >> 22) & 0x03;
+
+        entry->timestamp = getLe(record + 1, 4);
+        entry->boot = record[0] & MEASUREMENT_LOG_FLAG_BOOT;
+        entry->settings.mode = (lightMeterCompute_e)(record[0] & 0x07);
+        entry->settings.type = (lightMeterMode_e)((record[0] >> 3) & 0x01);
+        entry->settings.stopIncrement = increment;
+        entry->settings.isoIndex = (packed & 0x3F) + stopSeries(STOP_QUANTITY_ISO, increment).minIndex;
+        entry->settings.shutterIndex = ((packed >> 6) & 0x3F) + stopSeries(STOP_QUANTITY_SHUTTER, increment).minIndex;
+        entry->settings.apertureIndex = ((packed >> 12) & 0x3F) + stopSeries(STOP_QUANTITY_APERTURE, increment).minIndex;
+        entry->settings.ndFilterIndex = (packed >> 18) & 0x0F;
+        return MEASUREMENT_LOG_RECORD_KEYFRAME;
+    }
+
+    const uint8_t itIndex = (record[0] >> 2) & 0x07;
+
+    entry->timestamp += getLe(record + 1, 3);
+    entry->gain = record[0] & 0x03;
+    entry->integrationTimeMs = INTEGRATION_TIME_MS[itIndex < INTEGRATION_TIME_COUNT ? itIndex : 0];
+    entry->counts = getLe(record + 4, 2);
+    entry->ev = (int16_t)getLe(record + 6, 2) / 100.0f;
+    return MEASUREMENT_LOG_RECORD_SAMPLE;
+}
+
+bool MeasurementLog::begin() {
+    if (!LittleFS.begin(true)) {
+        return false;
+    }
+
+    _file = LittleFS.open(MEASUREMENT_LOG_FILE, FILE_APPEND);
+    _enabled = (bool)_file;
+    return _enabled;
+}
+
+// Pads the page being filled and hands it to the flash writer
+void MeasurementLog::closePage() {
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+
+    memset(&_pages[head % MEASUREMENT_LOG_PAGE_COUNT][_slot * MEASUREMENT_LOG_RECORD_SIZE], 0xFF,
+           MEASUREMENT_LOG_PAGE_SIZE - _slot * MEASUREMENT_LOG_RECORD_SIZE);
+    _slot = 0;
+    _head.store(head + 1, std::memory_order_release);
+}
+
+/*
+  Sensor task side, only copies into RAM. When every page is still waiting
+  for flash the sample is dropped instead of waiting
+*/
+void MeasurementLog::append(const measurement_t &measurement) {
+    if (!_enabled) {
+        return;
+    }
+
+    const uint32_t now = millis();
+    const bool keyframe = _slot == 0 || !sameLoggedSettings(measurement.settings, _lastSettings) ||
+                          now - _lastTimestamp > MEASUREMENT_LOG_DELTA_MAX;
+
+    // A keyframe and its sample go into the same page
+    if (keyframe && _slot == MEASUREMENT_LOG_RECORDS_PER_PAGE - 1) {
+        closePage();
+    }
+
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    if (_slot == 0 && head - _tail.load(std::memory_order_acquire) >= MEASUREMENT_LOG_PAGE_COUNT) {
+        _droppedRecords++;
+        return;
+    }
+
+    uint8_t *page = _pages[head % MEASUREMENT_LOG_PAGE_COUNT];
+
+    if (keyframe) {
+        encodeKeyframe(&page[_slot * MEASUREMENT_LOG_RECORD_SIZE], now, measurement.settings, _boot);
+        _slot++;
+        _boot = false;
+        _lastTimestamp = now;
+        _lastSettings = measurement.settings;
+    }
+
+    encodeSample(&page[_slot * MEASUREMENT_LOG_RECORD_SIZE], now - _lastTimestamp, measurement);
+    _slot++;
+    _lastTimestamp = now;
+    _recordCount++;
+
+    if (_slot == MEASUREMENT_LOG_RECORDS_PER_PAGE || _flushRequested.exchange(false)) {
+        closePage();
+    }
+}
+
+void MeasurementLog::writePage() {
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+    // Page is dropped if the file could not be reopened after rotation
+    if (_file) {
+        _file.write(_pages[tail % MEASUREMENT_LOG_PAGE_COUNT], MEASUREMENT_LOG_PAGE_SIZE);
+        _file.flush();
+        _pageWrites++;
+    }
+
+    _tail.store(tail + 1, std::memory_order_release);
+}
+
+// Keeps the newest two files, the oldest one is dropped
+void MeasurementLog::rotate() {
+    _file.close();
+    LittleFS.remove(MEASUREMENT_LOG_FILE_OLD);
+    LittleFS.rename(MEASUREMENT_LOG_FILE, MEASUREMENT_LOG_FILE_OLD);
+    _file = LittleFS.open(MEASUREMENT_LOG_FILE, FILE_APPEND);
+}
+
+// UI loop side
+void MeasurementLog::loop() {
+    if (!_enabled) {
+        return;
+    }
+
+    // One page per call keeps the UI stall down to a single flash write
+    if (_tail.load(std::memory_order_relaxed) != _head.load(std::memory_order_acquire)) {
+        writePage();
+    }
+
+    // Files are read by position while dumping, rotation waits for it to finish
+    if (!isDumping() && _file.size() >= MEASUREMENT_LOG_FILE_MAX_BYTES) {
+        rotate();
+    }
+
+    dumpStep();
+}
+
+void MeasurementLog::startDump() {
+    if (!_enabled || isDumping()) {
+        return;
+    }
+
+    _dumpState = MEASUREMENT_LOG_DUMP_FLUSHING;
+    _dumpStartedAt = millis();
+    requestFlush();
+}
+
+void MeasurementLog::dumpStep() {
+    if (_dumpState == MEASUREMENT_LOG_DUMP_FLUSHING) {
+        const bool flushPending = _flushRequested && millis() - _dumpStartedAt < MEASUREMENT_LOG_FLUSH_TIMEOUT_MS;
+
+        if (flushPending || _tail.load(std::memory_order_relaxed) != _head.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        char header[32];
+        _dumpFile = LittleFS.open(MEASUREMENT_LOG_FILE_OLD, FILE_READ);
+        _dumpingOld = (bool)_dumpFile;
+        _dumpCurrentSize = _file.size();
+        _dumpRemaining = _dumpingOld ? _dumpFile.size() : _dumpCurrentSize;
+        if (!_dumpingOld) {
+            _dumpFile = LittleFS.open(MEASUREMENT_LOG_FILE, FILE_READ);
+        }
+
+        snprintf(header, sizeof(header), "LOG BEGIN %lu\n", (unsigned long)(_dumpRemaining + (_dumpingOld ? _dumpCurrentSize : 0)));
+        Serial.print(header);
+        _dumpState = MEASUREMENT_LOG_DUMP_SENDING;
+        return;
+    }
+
+    if (_dumpState != MEASUREMENT_LOG_DUMP_SENDING) {
+        return;
+    }
+
+    if (_dumpRemaining == 0) {
+        _dumpFile.close();
+
+        if (_dumpingOld) {
+            _dumpFile = LittleFS.open(MEASUREMENT_LOG_FILE, FILE_READ);
+            _dumpRemaining = _dumpCurrentSize;
+            _dumpingOld = false;
+        } else {
+            Serial.print("LOG END\n");
+            _dumpState = MEASUREMENT_LOG_DUMP_IDLE;
+        }
+        return;
+    }
+
+    // Never more than the UART takes without blocking
+    uint8_t chunk[MEASUREMENT_LOG_DUMP_CHUNK];
+    const uint32_t room = constrain(Serial.availableForWrite(), 0, MEASUREMENT_LOG_DUMP_CHUNK);
+    const size_t size = _dumpFile.read(chunk, room < _dumpRemaining ? room : _dumpRemaining);
+
+    if (room > 0 && size == 0) {
+        // File shorter than expected, end this part
+        _dumpRemaining = 0;
+        return;
+    }
+
+    Serial.write(chunk, size);
+    _dumpRemaining -= size;
+}
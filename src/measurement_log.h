@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef MEASUREMENT_LOG_H
+#define MEASUREMENT_LOG_H
+
+#include "Arduino.h"
+#include <atomic>
+#include <LittleFS.h>
+#include "types.h"
+#include "measurement.h"
+
+#define MEASUREMENT_LOG_FILE "/log.bin"
+// Previous file after rotation, the log keeps at most two files
+#define MEASUREMENT_LOG_FILE_OLD "/log.old"
+#define MEASUREMENT_LOG_FILE_MAX_BYTES (512 * 1024)
+
+/*
+  Fixed 8 byte records, little endian, batched into flash page sized
+  writes. Every page starts with a keyframe, so pages decode on their own
+*/
+#define MEASUREMENT_LOG_RECORD_SIZE 8
+#define MEASUREMENT_LOG_PAGE_SIZE 256
+#define MEASUREMENT_LOG_RECORDS_PER_PAGE (MEASUREMENT_LOG_PAGE_SIZE / MEASUREMENT_LOG_RECORD_SIZE)
+// Pages buffered in RAM between the sensor task and the flash writer
+#define MEASUREMENT_LOG_PAGE_COUNT 4
+
+#define MEASUREMENT_LOG_DUMP_CHUNK 64
+
+/*
+  Sample record:
+    [0]    flags: bit 7 clear, bits 0-1 VEML7700 gain, bits 2-4 integration time index
+    [1..3] milliseconds since the previous record
+    [4..5] raw counts
+    [6..7] EV x100
+  Keyframe, written at the start of every page and when settings change:
+    [0]    flags: bit 7 set, bits 0-2 mode, bit 3 type, bit 4 first record after boot
+    [1..4] milliseconds since boot
+    [5..7] iso, shutter and aperture index from the start of their series (6 bits each),
+           ndFilterIndex (4 bits), stopIncrement (2 bits)
+  Unused slots at the end of a flushed page are all 0xFF
+*/
+#define MEASUREMENT_LOG_FLAG_KEYFRAME 0x80
+#define MEASUREMENT_LOG_FLAG_BOOT 0x10
+#define MEASUREMENT_LOG_DELTA_MAX 0xFFFFFF
+
+enum measurementLogRecord_e {
+    MEASUREMENT_LOG_RECORD_EMPTY = 0,
+    MEASUREMENT_LOG_RECORD_KEYFRAME,
+    MEASUREMENT_LOG_RECORD_SAMPLE
+};
+
+enum measurementLogDump_e {
+    MEASUREMENT_LOG_DUMP_IDLE = 0,
+    MEASUREMENT_LOG_DUMP_FLUSHING,
+    MEASUREMENT_LOG_DUMP_SENDING
+};
+
+// One decoded sample with the state of the keyframes before it
+typedef struct measurementLogEntry_s {
+    uint32_t timestamp;
+    uint16_t counts;
+    uint8_t gain;
+    uint16_t integrationTimeMs;
+    float ev;
+    settings_t settings;
+    bool boot;
+} measurementLogEntry_t;
+
+/*
+  Shoot day log. The sensor task appends into RAM pages and never touches
+  flash, full pages are written from the UI loop. A dump streams both log
+  files over Serial in chunks that fit the UART FIFO, framed by a
+  "LOG BEGIN <bytes>" line and a "LOG END" line
+*/
+class MeasurementLog {
+    public:
+        bool begin();
+        void append(const measurement_t &measurement);
+        void loop();
+        // Asks the sensor task to close the page it is filling with its next sample
+        void requestFlush() { _flushRequested = true; }
+        void startDump();
+        bool isDumping() { return _dumpState != MEASUREMENT_LOG_DUMP_IDLE; }
+        uint32_t getRecordCount() { return _recordCount; }
+        uint32_t getPageWrites() { return _pageWrites; }
+        uint32_t getDroppedRecords() { return _droppedRecords; }
+        static uint8_t decodeRecord(const uint8_t *record, measurementLogEntry_t *entry);
+    private:
+        bool reserve(uint8_t slots);
+        void closePage();
+        void writePage();
+        void rotate();
+        void dumpStep();
+        bool _enabled = false;
+        File _file;
+        uint8_t _pages[MEASUREMENT_LOG_PAGE_COUNT][MEASUREMENT_LOG_PAGE_SIZE];
+        // Free running page counters, head is only moved by the sensor task, tail by the UI loop
+        std::atomic<uint32_t> _head{0};
+        std::atomic<uint32_t> _tail{0};
+        std::atomic<bool> _flushRequested{false};
+        uint8_t _slot = 0;
+        uint32_t _lastTimestamp = 0;
+        settings_t _lastSettings;
+        bool _boot = true;
+        uint32_t _recordCount = 0;
+        uint32_t _pageWrites = 0;
+        uint32_t _droppedRecords = 0;
+        measurementLogDump_e _dumpState = MEASUREMENT_LOG_DUMP_IDLE;
+        uint32_t _dumpStartedAt = 0;
+        File _dumpFile;
+        bool _dumpingOld = false;
+        uint32_t _dumpRemaining = 0;
+        uint32_t _dumpCurrentSize = 0;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "measurement_memory.h"
+
+void MeasurementMemory::push(int16_t evHundredths, uint32_t timestamp) {
+    // The oldest reading leaves, it can only be at the front of the queues
+    if (_count == MEASUREMENT_MEMORY_CAPACITY) {
+        const uint32_t oldest = first();
+
+        _sum -= value(oldest);
+        if (_minLength > 0 && _minQueue[_minFront] == oldest) {
+            _minFront = (_minFront + 1) % MEASUREMENT_MEMORY_CAPACITY;
+            _minLength--;
+        }
+        if (_maxLength > 0 && _maxQueue[_maxFront] == oldest) {
+            _maxFront = (_maxFront + 1) % MEASUREMENT_MEMORY_CAPACITY;
+            _maxLength--;
+        }
+        _count--;
+    }
+
+    const uint32_t number = _pushed++;
+
+    _readings[number % MEASUREMENT_MEMORY_CAPACITY] = {evHundredths, timestamp};
+    _count++;
+    _sum += evHundredths;
+    _cursor = number;
+
+    // Readings the new one outlives and beats can't become min or max any more
+    while (_minLength > 0 && value(_minQueue[(_minFront + _minLength - 1) % MEASUREMENT_MEMORY_CAPACITY]) >= evHundredths) {
+        _minLength--;
+    }
+    _minQueue[(_minFront + _minLength++) % MEASUREMENT_MEMORY_CAPACITY] = number;
+
+    while (_maxLength > 0 && value(_maxQueue[(_maxFront + _maxLength - 1) % MEASUREMENT_MEMORY_CAPACITY]) <= evHundredths) {
+        _maxLength--;
+    }
+    _maxQueue[(_maxFront + _maxLength++) % MEASUREMENT_MEMORY_CAPACITY] = number;
+}
+
+const memoryReading_t &MeasurementMemory::get(uint8_t position) {
+    position = (position < _count) ? position : _count - 1;
+    return _readings[(first() + position) % MEASUREMENT_MEMORY_CAPACITY];
+}
+
+int16_t MeasurementMemory::getMean() {
+    if (_count == 0) {
+        return 0;
+    }
+    // Rounded, not truncated towards zero
+    return (_sum + ((_sum < 0) ? -_count / 2 : _count / 2)) / _count;
+}
+
+int16_t MeasurementMemory::getMin() {
+    return (_minLength > 0) ? value(_minQueue[_minFront]) : 0;
+}
+
+int16_t MeasurementMemory::getMax() {
+    return (_maxLength > 0) ? value(_maxQueue[_maxFront]) : 0;
+}
+
+void MeasurementMemory::moveCursor(int8_t positions) {
+    if (_count == 0) {
+        return;
+    }
+
+    const int16_t position = constrain((int16_t)(_cursor - first()) + positions, 0, _count - 1);
+    _cursor = first() + position;
+}
+
+int16_t MeasurementMemory::getRatioHundredths() {
+    return hasRatio() ? value(_key) - value(_fill) : 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef MEASUREMENT_MEMORY_H
+#define MEASUREMENT_MEMORY_H
+
+#include "Arduino.h"
+
+#define MEASUREMENT_MEMORY_CAPACITY 16
+
+typedef struct memoryReading_s {
+    // Metered EV at ISO 100, x100
+    int16_t evHundredths;
+    uint32_t timestamp;
+} memoryReading_t;
+
+/*
+  Readings frozen with Hold, the oldest one is dropped when the ring is
+  full. Sum, min and max are kept up to date on every push, min and max
+  with monotonic queues, so none of the statistics look at the history.
+  Readings are addressed by position, 0 is the oldest one still stored
+*/
+class MeasurementMemory {
+    public:
+        void push(int16_t evHundredths, uint32_t timestamp);
+        uint8_t getCount() { return _count; }
+        const memoryReading_t &get(uint8_t position);
+        int16_t getMean();
+        int16_t getMin();
+        int16_t getMax();
+        int16_t getSpread() { return getMax() - getMin(); }
+        // Browsing cursor, moved to the newest reading on every push
+        uint8_t getCursor() { return _cursor - first(); }
+        void moveCursor(int8_t positions);
+        // Key and fill light for the ratio, marked at the cursor
+        void markKey() { _key = _cursor; }
+        void markFill() { _fill = _cursor; }
+        bool isKey(uint8_t position) { return _key == first() + position; }
+        bool isFill(uint8_t position) { return _fill == first() + position; }
+        bool hasRatio() { return stored(_key) && stored(_fill); }
+        // Key minus fill in stops x100, the lighting ratio is 2^stops
+        int16_t getRatioHundredths();
+    private:
+        // Readings are numbered in push order, the ring slot is number % capacity
+        uint32_t first() { return _pushed - _count; }
+        bool stored(uint32_t number) { return number != UINT32_MAX && number >= first() && number < _pushed; }
+        int16_t value(uint32_t number) { return _readings[number % MEASUREMENT_MEMORY_CAPACITY].evHundredths; }
+        memoryReading_t _readings[MEASUREMENT_MEMORY_CAPACITY] = {};
+        uint32_t _pushed = 0;
+        uint8_t _count = 0;
+        int32_t _sum = 0;
+        // Reading numbers with increasing (min) or decreasing (max) values, front is the extreme
+        uint32_t _minQueue[MEASUREMENT_MEMORY_CAPACITY] = {};
+        uint32_t _maxQueue[MEASUREMENT_MEMORY_CAPACITY] = {};
+        uint8_t _minFront = 0;
+        uint8_t _minLength = 0;
+        uint8_t _maxFront = 0;
+        uint8_t _maxLength = 0;
+        uint32_t _cursor = 0;
+        uint32_t _key = UINT32_MAX;
+        uint32_t _fill = UINT32_MAX;
+};
+
+#endif
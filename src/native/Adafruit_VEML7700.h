@@ -0,0 +1,70 @@
+/*
+  VEML7700 stand-in for the native host build. Produces raw ALS counts for
+  the simulated scene illuminance set through native_sim.h, including the
+  non-linearity of the low gain ranges and the settling time after a
+  gain or integration time change
+*/
+#pragma once
+
+#ifndef NATIVE_ADAFRUIT_VEML7700_H
+#define NATIVE_ADAFRUIT_VEML7700_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define VEML7700_GAIN_1 0x00
+#define VEML7700_GAIN_2 0x01
+#define VEML7700_GAIN_1_8 0x02
+#define VEML7700_GAIN_1_4 0x03
+
+#define VEML7700_IT_100MS 0x00
+#define VEML7700_IT_200MS 0x01
+#define VEML7700_IT_400MS 0x02
+#define VEML7700_IT_800MS 0x03
+#define VEML7700_IT_50MS 0x08
+#define VEML7700_IT_25MS 0x0C
+
+#define VEML7700_POWERSAVE_MODE1 0x00
+#define VEML7700_POWERSAVE_MODE2 0x01
+#define VEML7700_POWERSAVE_MODE3 0x02
+#define VEML7700_POWERSAVE_MODE4 0x03
+
+typedef enum {
+    VEML_LUX_NORMAL,
+    VEML_LUX_CORRECTED,
+    VEML_LUX_AUTO,
+    VEML_LUX_NORMAL_NOWAIT,
+    VEML_LUX_CORRECTED_NOWAIT
+} luxMethod;
+
+class Adafruit_VEML7700 {
+    public:
+        bool begin(TwoWire *theWire = &Wire);
+        void enable(bool enable);
+        bool enabled() { return _enabled; }
+        void setGain(uint8_t gain);
+        uint8_t getGain() { return _gain; }
+        void setIntegrationTime(uint8_t it, bool wait = true);
+        uint8_t getIntegrationTime() { return _integrationTime; }
+        int getIntegrationTimeValue();
+        float getGainValue();
+        float getResolution();
+        void powerSaveEnable(bool enable);
+        bool powerSaveEnabled() { return _powerSave; }
+        void setPowerSaveMode(uint8_t mode);
+        uint8_t getPowerSaveMode() { return _powerSaveMode; }
+        uint16_t readALS(bool wait = false);
+        float readLux(luxMethod method = VEML_LUX_NORMAL);
+    private:
+        uint16_t convert(float lux);
+        uint32_t getPowerSaveWait();
+        bool _enabled = false;
+        uint8_t _gain = VEML7700_GAIN_1;
+        uint8_t _integrationTime = VEML7700_IT_100MS;
+        bool _powerSave = false;
+        uint8_t _powerSaveMode = VEML7700_POWERSAVE_MODE1;
+        uint32_t _configuredAt = 0;
+        uint16_t _lastCounts = 0;
+};
+
+#endif
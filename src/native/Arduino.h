@@ -0,0 +1,244 @@
+/*
+  Minimal Arduino / ESP32 core stand-in for the native host build.
+  Only what the light meter sources use is provided. Time is simulated,
+  see native_sim.h
+*/
+#pragma once
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+typedef uint8_t byte;
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define CHANGE 0x03
+#define IRAM_ATTR
+#define digitalPinToInterrupt(pin) (pin)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define PI 3.1415926535897932384626433832795
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// CPU cycle counter, TSC on x86 hosts, nanoseconds elsewhere
+class EspClass {
+    public:
+        uint32_t getCycleCount();
+};
+
+extern EspClass ESP;
+
+// Only recorded, simulated time doesn't depend on the clock
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+
+void setup();
+void loop();
+
+/*
+  Arduino String with the ESP32 core small string optimisation: up to
+  STRING_SSO_SIZE characters live inside the object, longer text goes to
+  the heap, so host heap accounting matches the device
+*/
+#define STRING_SSO_SIZE 11
+
+class String {
+    public:
+        String(const char *str = "") { assign(str ? str : "", str ? strlen(str) : 0); }
+        String(const String &other) { assign(other.c_str(), other._length); }
+        explicit String(int value) { format("%d", value); }
+        explicit String(long value) { format("%ld", value); }
+        explicit String(unsigned int value) { format("%u", value); }
+        explicit String(unsigned long value) { format("%lu", value); }
+        String(float value, unsigned int decimalPlaces = 2) { formatFloat(value, decimalPlaces); }
+        String(double value, unsigned int decimalPlaces = 2) { formatFloat(value, decimalPlaces); }
+        ~String() { delete[] _heap; }
+
+        String &operator=(const String &rhs) {
+            if (this != &rhs) {
+                String copy(rhs);
+                delete[] _heap;
+                _heap = nullptr;
+                assign(copy.c_str(), copy._length);
+            }
+            return *this;
+        }
+
+        const char *c_str() const { return _heap ? _heap : _sso; }
+        unsigned int length() const { return _length; }
+        char charAt(unsigned int index) const { return c_str()[index]; }
+
+        String &operator+=(const String &rhs) { return append(rhs.c_str(), rhs._length); }
+        String &operator+=(const char *rhs) { return append(rhs, strlen(rhs)); }
+        bool operator==(const String &rhs) const { return strcmp(c_str(), rhs.c_str()) == 0; }
+        bool operator!=(const String &rhs) const { return !(*this == rhs); }
+
+        friend String operator+(const String &lhs, const String &rhs) { String result(lhs); return result += rhs; }
+        friend String operator+(const char *lhs, const String &rhs) { String result(lhs); return result += rhs; }
+        friend String operator+(const String &lhs, const char *rhs) { String result(lhs); return result += rhs; }
+    private:
+        void assign(const char *str, size_t length) {
+            char *target = _sso;
+            if (length > STRING_SSO_SIZE) {
+                _heap = new char[length + 1];
+                target = _heap;
+            }
+            memcpy(target, str, length);
+            target[length] = '\0';
+            _length = length;
+        }
+        String &append(const char *str, size_t length) {
+            const size_t total = _length + length;
+            if (total > STRING_SSO_SIZE) {
+                char *grown = new char[total + 1];
+                memcpy(grown, c_str(), _length);
+                memcpy(grown + _length, str, length);
+                grown[total] = '\0';
+                delete[] _heap;
+                _heap = grown;
+            } else {
+                memcpy(_sso + _length, str, length);
+                _sso[total] = '\0';
+            }
+            _length = total;
+            return *this;
+        }
+        template <class T> void format(const char *fmt, T value) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), fmt, value);
+            assign(buf, strlen(buf));
+        }
+        void formatFloat(double value, unsigned int decimalPlaces) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+            assign(buf, strlen(buf));
+        }
+        char _sso[STRING_SSO_SIZE + 1];
+        char *_heap = nullptr;
+        size_t _length = 0;
+};
+
+// Serial port model, implemented in native_sim.cpp
+size_t simSerialWrite(const uint8_t *buf, size_t size);
+int simSerialAvailableForWrite();
+int simSerialAvailable();
+int simSerialRead();
+void simSerialSetTxBufferSize(size_t size);
+
+class HardwareSerial {
+    public:
+        void begin(unsigned long baud) { (void)baud; }
+        size_t setTxBufferSize(size_t size) { simSerialSetTxBufferSize(size); return size; }
+        size_t write(uint8_t c) { return simSerialWrite(&c, 1); }
+        size_t write(const uint8_t *buf, size_t size) { return simSerialWrite(buf, size); }
+        size_t print(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+        size_t print(const String &str) { return print(str.c_str()); }
+        size_t print(float value, int decimals = 2) { return printFormat("%.*f", decimals, value); }
+        size_t print(int value) { return printFormat("%d", value); }
+        size_t print(unsigned long value) { return printFormat("%lu", value); }
+        template <class T> size_t println(const T &value) { size_t n = print(value); return n + print("\n"); }
+        size_t println() { return print("\n"); }
+        int availableForWrite() { return simSerialAvailableForWrite(); }
+        int available() { return simSerialAvailable(); }
+        int read() { return simSerialRead(); }
+        void flush() {}
+    private:
+        template <class... T> size_t printFormat(const char *fmt, T... values) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), fmt, values...);
+            return print(buf);
+        }
+};
+
+extern HardwareSerial Serial;
+
+/*
+  FreeRTOS subset. Tasks are not scheduled on the host, the native runner
+  steps the task bodies itself on simulated time.
+*/
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef int BaseType_t;
+
+typedef void *QueueHandle_t;
+
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdPASS 1
+#define pdTRUE 1
+#define pdFALSE 0
+
+// Host runs everything on one thread, critical sections are no-ops
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portYIELD_FROM_ISR()
+
+TickType_t xTaskGetTickCount();
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t timeIncrement);
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+void xTaskNotifyGive(TaskHandle_t task);
+/*
+  Queues never block on the host: receive returns pdFALSE right away when
+  empty and the runner calls loop() again on the next simulated tick
+*/
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higherPriorityTaskWoken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait);
+
+// Binary semaphores are queues of one token, as in FreeRTOS
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 1);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    const uint8_t token = 0;
+    return xQueueSend(semaphore, &token, 0);
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    uint8_t token;
+    return xQueueReceive(semaphore, &token, ticksToWait);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth,
+                                   void *parameters, unsigned int priority, TaskHandle_t *createdTask, int coreId);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+  EEPROM stand-in for the native host build. Keeps the emulated EEPROM in
+  RAM and counts commits, each commit is a flash sector erase on ESP32
+*/
+#pragma once
+
+#ifndef NATIVE_EEPROM_H
+#define NATIVE_EEPROM_H
+
+#include "Arduino.h"
+
+#define NATIVE_EEPROM_MAX_SIZE 4096
+
+class EEPROMClass {
+    public:
+        bool begin(size_t size);
+        uint8_t read(int address);
+        void write(int address, uint8_t value);
+        bool commit();
+        uint32_t getCommitCount() { return _commitCount; }
+    private:
+        uint8_t _data[NATIVE_EEPROM_MAX_SIZE];
+        size_t _size = 0;
+        uint32_t _commitCount = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,122 @@
+#ifdef NATIVE_BUILD
+
+#include "LittleFS.h"
+#include "native_sim.h"
+#include <map>
+#include <string>
+
+// Size of the spiffs partition in partitions.csv
+#define SIM_FS_SIZE 0x15C000
+
+LittleFSFS LittleFS;
+
+static std::map<std::string, std::vector<uint8_t>> simFiles;
+static uint32_t simFsWrites = 0;
+static uint32_t simFsWriteBytes = 0;
+
+File::File(std::vector<uint8_t> *data, bool append) {
+    _data = data;
+    _position = append ? data->size() : 0;
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+    if (_data == nullptr) {
+        return 0;
+    }
+    if (_position + size > _data->size()) {
+        _data->resize(_position + size);
+    }
+    memcpy(_data->data() + _position, buf, size);
+    _position += size;
+
+    simFsWrites++;
+    simFsWriteBytes += size;
+    return size;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+    if (_data == nullptr || _position >= _data->size()) {
+        return 0;
+    }
+    if (size > _data->size() - _position) {
+        size = _data->size() - _position;
+    }
+    memcpy(buf, _data->data() + _position, size);
+    _position += size;
+    return size;
+}
+
+int File::available() {
+    return (_data == nullptr) ? 0 : _data->size() - _position;
+}
+
+bool File::seek(uint32_t position) {
+    if (_data == nullptr || position > _data->size()) {
+        return false;
+    }
+    _position = position;
+    return true;
+}
+
+size_t File::size() {
+    return (_data == nullptr) ? 0 : _data->size();
+}
+
+bool LittleFSFS::begin(bool formatOnFail) {
+    (void)formatOnFail;
+    return true;
+}
+
+File LittleFSFS::open(const char *path, const char *mode) {
+    const bool exists = simFiles.count(path) > 0;
+
+    if (strcmp(mode, FILE_READ) == 0) {
+        return exists ? File(&simFiles[path], false) : File();
+    }
+
+    std::vector<uint8_t> *data = &simFiles[path];
+    if (strcmp(mode, FILE_WRITE) == 0) {
+        data->clear();
+    }
+    return File(data, true);
+}
+
+bool LittleFSFS::exists(const char *path) {
+    return simFiles.count(path) > 0;
+}
+
+bool LittleFSFS::remove(const char *path) {
+    return simFiles.erase(path) > 0;
+}
+
+bool LittleFSFS::rename(const char *pathFrom, const char *pathTo) {
+    auto from = simFiles.find(pathFrom);
+    if (from == simFiles.end()) {
+        return false;
+    }
+    simFiles[pathTo] = std::move(from->second);
+    simFiles.erase(pathFrom);
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return SIM_FS_SIZE;
+}
+
+size_t LittleFSFS::usedBytes() {
+    size_t used = 0;
+    for (const auto &file : simFiles) {
+        used += file.second.size();
+    }
+    return used;
+}
+
+uint32_t simGetFsWrites() {
+    return simFsWrites;
+}
+
+uint32_t simGetFsWriteBytes() {
+    return simFsWriteBytes;
+}
+
+#endif
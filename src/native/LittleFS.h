@@ -0,0 +1,50 @@
+/*
+  LittleFS stand-in for the native host build. Files are RAM backed, the
+  subset of the arduino-esp32 FS API the firmware uses is implemented and
+  every write reaching "flash" is counted
+*/
+#pragma once
+
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include "Arduino.h"
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+class File {
+    public:
+        File() {}
+        File(std::vector<uint8_t> *data, bool append);
+        size_t write(const uint8_t *buf, size_t size);
+        size_t read(uint8_t *buf, size_t size);
+        int available();
+        bool seek(uint32_t position);
+        size_t position() { return _position; }
+        size_t size();
+        void flush() {}
+        void close() { _data = nullptr; }
+        operator bool() const { return _data != nullptr; }
+    private:
+        std::vector<uint8_t> *_data = nullptr;
+        size_t _position = 0;
+};
+
+class LittleFSFS {
+    public:
+        bool begin(bool formatOnFail = false);
+        void end() {}
+        File open(const char *path, const char *mode = FILE_READ);
+        bool exists(const char *path);
+        bool remove(const char *path);
+        bool rename(const char *pathFrom, const char *pathTo);
+        size_t totalBytes();
+        size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,90 @@
+#ifdef NATIVE_BUILD
+
+#include "Preferences.h"
+#include "native_sim.h"
+#include <map>
+#include <vector>
+
+static std::map<std::string, std::vector<uint8_t>> simNvs;
+static uint32_t simNvsWrites = 0;
+
+// NVS limits namespace and key names to 15 characters
+#define SIM_NVS_KEY_MAX 15
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel) {
+    (void)partitionLabel;
+    if (_started || strlen(name) > SIM_NVS_KEY_MAX) {
+        return false;
+    }
+    _namespace = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+std::string Preferences::path(const char *key) {
+    return _namespace + "/" + key;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) {
+        return false;
+    }
+    const std::string prefix = _namespace + "/";
+    for (auto it = simNvs.begin(); it != simNvs.end();) {
+        it = (it->first.compare(0, prefix.size(), prefix) == 0) ? simNvs.erase(it) : std::next(it);
+    }
+    simNvsWrites++;
+    return true;
+}
+
+bool Preferences::remove(const char *key) {
+    if (!_started || _readOnly) {
+        return false;
+    }
+    simNvsWrites++;
+    return simNvs.erase(path(key)) > 0;
+}
+
+bool Preferences::isKey(const char *key) {
+    return _started && simNvs.count(path(key)) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length) {
+    if (!_started || _readOnly || strlen(key) > SIM_NVS_KEY_MAX) {
+        return 0;
+    }
+    const uint8_t *bytes = (const uint8_t *)value;
+    simNvs[path(key)].assign(bytes, bytes + length);
+    simNvsWrites++;
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    if (!_started) {
+        return 0;
+    }
+    const auto it = simNvs.find(path(key));
+    return (it != simNvs.end()) ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLength) {
+    const size_t length = getBytesLength(key);
+
+    // Like the real one, a buffer too small for the blob reads nothing
+    if (length == 0 || length > maxLength) {
+        return 0;
+    }
+    memcpy(buf, simNvs[path(key)].data(), length);
+    return length;
+}
+
+uint32_t simGetNvsWrites() {
+    return simNvsWrites;
+}
+
+#endif
@@ -0,0 +1,31 @@
+/*
+  Preferences (NVS) stand-in for the native host build. Namespaces and
+  keys live in RAM for the life of the process, only the blob calls the
+  firmware uses are implemented and every put is counted
+*/
+#pragma once
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include "Arduino.h"
+#include <string>
+
+class Preferences {
+    public:
+        bool begin(const char *name, bool readOnly = false, const char *partitionLabel = NULL);
+        void end();
+        bool clear();
+        bool remove(const char *key);
+        bool isKey(const char *key);
+        size_t putBytes(const char *key, const void *value, size_t length);
+        size_t getBytesLength(const char *key);
+        size_t getBytes(const char *key, void *buf, size_t maxLength);
+    private:
+        std::string path(const char *key);
+        std::string _namespace;
+        bool _started = false;
+        bool _readOnly = false;
+};
+
+#endif
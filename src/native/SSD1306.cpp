@@ -0,0 +1,253 @@
+#ifdef NATIVE_BUILD
+
+#include "SSD1306.h"
+
+#include "native_sim.h"
+
+#define SSD1306_CONTROL_COMMAND 0x00
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_CHUNK_SIZE 16
+
+SSD1306::SSD1306(uint8_t address, int sda, int scl) {
+    (void)sda;
+    (void)scl;
+    _address = address;
+    memset(buffer, 0, sizeof(buffer));
+    memset(_panel, 0, sizeof(_panel));
+    simRegisterI2cDevice(address, panelWrite, this);
+}
+
+// The ThingPulse driver runs the bus at 700 kHz unless told otherwise
+bool SSD1306::init() {
+    Wire.setClock(700000);
+    clear();
+    return true;
+}
+
+void SSD1306::clear() {
+    memset(buffer, 0, sizeof(buffer));
+}
+
+/*
+  Full frame transfer the way the ThingPulse driver does it: set the whole
+  address window, then stream the buffer in small data transactions
+*/
+void SSD1306::display() {
+    const uint8_t window[] = {
+        SSD1306_CONTROL_COMMAND,
+        SSD1306_COLUMNADDR, 0, DISPLAY_WIDTH - 1,
+        SSD1306_PAGEADDR, 0, DISPLAY_HEIGHT / 8 - 1
+    };
+
+    Wire.beginTransmission(_address);
+    Wire.write(window, sizeof(window));
+    Wire.endTransmission();
+
+    for (uint16_t i = 0; i < DISPLAY_BUFFER_SIZE; i += SSD1306_CHUNK_SIZE) {
+        Wire.beginTransmission(_address);
+        Wire.write(SSD1306_CONTROL_DATA);
+        Wire.write(buffer + i, SSD1306_CHUNK_SIZE);
+        Wire.endTransmission();
+    }
+
+    _flushCount++;
+}
+
+void SSD1306::panelWrite(void *context, const uint8_t *data, size_t size) {
+    SSD1306 *self = (SSD1306 *)context;
+
+    if (size == 0) {
+        return;
+    }
+
+    const bool isData = data[0] & SSD1306_CONTROL_DATA;
+    for (size_t i = 1; i < size; i++) {
+        if (isData) {
+            self->panelData(data[i]);
+        } else {
+            self->panelCommand(data[i]);
+        }
+    }
+}
+
+// Addressing, contrast and display on/off are modelled, the rest are ignored
+void SSD1306::panelCommand(uint8_t command) {
+    if (_pendingArgs > 0) {
+        if (_lastCommand == SSD1306_COLUMNADDR) {
+            if (_argIndex == 0) {
+                _columnStart = command & 0x7F;
+            } else {
+                _columnEnd = command & 0x7F;
+            }
+            _column = _columnStart;
+        } else if (_lastCommand == SSD1306_PAGEADDR) {
+            if (_argIndex == 0) {
+                _pageStart = command & 0x07;
+            } else {
+                _pageEnd = command & 0x07;
+            }
+            _page = _pageStart;
+        } else if (_lastCommand == SSD1306_SETCONTRAST) {
+            _contrast = command;
+        }
+        _argIndex++;
+        _pendingArgs--;
+        return;
+    }
+
+    _lastCommand = command;
+    _argIndex = 0;
+    if (command == SSD1306_COLUMNADDR || command == SSD1306_PAGEADDR) {
+        _pendingArgs = 2;
+    } else if (command == SSD1306_SETCONTRAST) {
+        _pendingArgs = 1;
+    } else if (command == SSD1306_DISPLAYOFF || command == SSD1306_DISPLAYON) {
+        _panelOn = command == SSD1306_DISPLAYON;
+    }
+}
+
+// Horizontal addressing mode, wraps inside the current address window
+void SSD1306::panelData(uint8_t data) {
+    _panel[_column + _page * DISPLAY_WIDTH] = data;
+
+    if (_column < _columnEnd) {
+        _column++;
+        return;
+    }
+
+    _column = _columnStart;
+    _page = (_page < _pageEnd) ? _page + 1 : _pageStart;
+}
+
+void SSD1306::setFont(const char *fontData) {
+    _font = (const uint8_t *)fontData;
+}
+
+void SSD1306::setFont(const uint8_t *fontData) {
+    _font = fontData;
+}
+
+void SSD1306::setPixel(int16_t x, int16_t y) {
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+        return;
+    }
+    buffer[x + (y / 8) * DISPLAY_WIDTH] |= (1 << (y & 7));
+}
+
+bool SSD1306::getPanelPixel(int16_t x, int16_t y) {
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+        return false;
+    }
+    return _panel[x + (y / 8) * DISPLAY_WIDTH] & (1 << (y & 7));
+}
+
+/*
+  Same font format as the ThingPulse driver: header, jump table of
+  (offset msb, offset lsb, size, width) and column major glyph data
+*/
+uint8_t SSD1306::drawChar(int16_t x, int16_t y, uint8_t c) {
+    const uint8_t firstChar = pgm_read_byte(_font + 2);
+    const uint8_t charCount = pgm_read_byte(_font + 3);
+
+    if (c < firstChar || c - firstChar >= charCount) {
+        return 0;
+    }
+
+    const uint8_t *jump = _font + FONT_HEADER_SIZE + (c - firstChar) * FONT_JUMP_SIZE;
+    const uint8_t msb = pgm_read_byte(jump);
+    const uint8_t lsb = pgm_read_byte(jump + 1);
+    const uint8_t size = pgm_read_byte(jump + 2);
+    const uint8_t width = pgm_read_byte(jump + 3);
+
+    if (msb == 0xFF && lsb == 0xFF) {
+        return width;
+    }
+
+    const uint8_t height = pgm_read_byte(_font + 1);
+    const uint8_t rasterHeight = 1 + ((height - 1) >> 3);
+    const uint8_t *data = _font + FONT_HEADER_SIZE + charCount * FONT_JUMP_SIZE + ((msb << 8) | lsb);
+
+    for (uint8_t i = 0; i < size; i++) {
+        const uint8_t bits = pgm_read_byte(data + i);
+        const int16_t column = x + i / rasterHeight;
+        const int16_t row = y + (i % rasterHeight) * 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (bits & (1 << bit)) {
+                setPixel(column, row + bit);
+            }
+        }
+    }
+
+    return width;
+}
+
+void SSD1306::drawString(int16_t x, int16_t y, const String &text) {
+    if (_font == nullptr) {
+        return;
+    }
+
+    const char *str = text.c_str();
+    while (*str) {
+        x += drawChar(x, y, (uint8_t)*str++);
+    }
+}
+
+uint16_t SSD1306::getStringWidth(const String &text) {
+    if (_font == nullptr) {
+        return 0;
+    }
+
+    const uint8_t firstChar = pgm_read_byte(_font + 2);
+    const uint8_t charCount = pgm_read_byte(_font + 3);
+    uint16_t width = 0;
+
+    for (const char *str = text.c_str(); *str; str++) {
+        const uint8_t c = (uint8_t)*str;
+        if (c >= firstChar && c - firstChar < charCount) {
+            width += pgm_read_byte(_font + FONT_HEADER_SIZE + (c - firstChar) * FONT_JUMP_SIZE + 3);
+        }
+    }
+    return width;
+}
+
+void SSD1306::drawHorizontalLine(int16_t x, int16_t y, int16_t length) {
+    for (int16_t i = 0; i < length; i++) {
+        setPixel(x + i, y);
+    }
+}
+
+void SSD1306::drawCircle(int16_t x0, int16_t y0, int16_t radius) {
+    int16_t x = 0;
+    int16_t y = radius;
+    int16_t dp = 1 - radius;
+
+    do {
+        if (dp < 0) {
+            dp = dp + (x++) * 2 + 3;
+        } else {
+            dp = dp + (x++) * 2 - (y--) * 2 + 5;
+        }
+
+        setPixel(x0 + x, y0 + y);
+        setPixel(x0 - x, y0 + y);
+        setPixel(x0 + x, y0 - y);
+        setPixel(x0 - x, y0 - y);
+        setPixel(x0 + y, y0 + x);
+        setPixel(x0 - y, y0 + x);
+        setPixel(x0 + y, y0 - x);
+        setPixel(x0 - y, y0 - x);
+    } while (x < y);
+
+    setPixel(x0 + radius, y0);
+    setPixel(x0, y0 + radius);
+    setPixel(x0 - radius, y0);
+    setPixel(x0, y0 - radius);
+}
+
+#endif
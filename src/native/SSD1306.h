@@ -0,0 +1,141 @@
+/*
+  SSD1306 stand-in for the native host build. Draws into the same page
+  organised 128x64 buffer layout as the ThingPulse driver. The panel side
+  is a minimal SSD1306 controller model on the simulated I2C bus, so
+  display() and any direct Wire writes land in the same RAM panel
+*/
+#pragma once
+
+#ifndef NATIVE_SSD1306_H
+#define NATIVE_SSD1306_H
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "../Lato_Bold_8.h"
+
+#define DISPLAY_WIDTH 128
+#define DISPLAY_HEIGHT 64
+#define DISPLAY_BUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)
+
+#define FONT_HEADER_SIZE 4
+#define FONT_JUMP_SIZE 4
+
+// Printable ASCII, a glyph is at most 255 bytes as the jump table counts it
+#define NATIVE_FONT_FIRST_CHAR 32
+#define NATIVE_FONT_CHAR_COUNT 95
+#define NATIVE_FONT_SIZE (FONT_HEADER_SIZE + NATIVE_FONT_CHAR_COUNT * (FONT_JUMP_SIZE + 255))
+
+typedef struct nativeFont_s {
+    uint8_t data[NATIVE_FONT_SIZE];
+} nativeFont_t;
+
+// Nearest neighbour scaling of every glyph, width and advance grow with the height
+static constexpr nativeFont_t nativeScaleFont(const uint8_t *source, uint8_t width, uint8_t height) {
+    nativeFont_t font = {};
+    const uint8_t sourceHeight = source[1];
+    const uint8_t sourceFirst = source[2];
+    const uint8_t sourceCount = source[3];
+    const uint8_t sourceRaster = 1 + ((sourceHeight - 1) >> 3);
+    const uint8_t raster = 1 + ((height - 1) >> 3);
+    const uint16_t data = FONT_HEADER_SIZE + NATIVE_FONT_CHAR_COUNT * FONT_JUMP_SIZE;
+    uint16_t offset = 0;
+
+    font.data[0] = width;
+    font.data[1] = height;
+    font.data[2] = NATIVE_FONT_FIRST_CHAR;
+    font.data[3] = NATIVE_FONT_CHAR_COUNT;
+
+    for (uint8_t i = 0; i < NATIVE_FONT_CHAR_COUNT; i++) {
+        const uint8_t *jump = source + FONT_HEADER_SIZE + (i + NATIVE_FONT_FIRST_CHAR - sourceFirst) * FONT_JUMP_SIZE;
+        const uint8_t *glyph = source + FONT_HEADER_SIZE + sourceCount * FONT_JUMP_SIZE + ((jump[0] << 8) | jump[1]);
+        const uint16_t targetJump = FONT_HEADER_SIZE + i * FONT_JUMP_SIZE;
+        const uint8_t columns = ((jump[2] + sourceRaster - 1) / sourceRaster * height + sourceHeight - 1) / sourceHeight;
+
+        font.data[targetJump + 3] = (jump[3] * height + sourceHeight / 2) / sourceHeight;
+        if (jump[0] == 0xFF && jump[1] == 0xFF) {
+            font.data[targetJump] = 0xFF;
+            font.data[targetJump + 1] = 0xFF;
+            continue;
+        }
+
+        for (uint8_t x = 0; x < columns; x++) {
+            for (uint8_t y = 0; y < height; y++) {
+                const uint8_t sourceY = y * sourceHeight / height;
+                const uint16_t index = (x * sourceHeight / height) * sourceRaster + sourceY / 8;
+
+                if (index < jump[2] && (glyph[index] >> (sourceY & 7)) & 1) {
+                    font.data[data + offset + x * raster + y / 8] |= 1 << (y & 7);
+                }
+            }
+        }
+
+        font.data[targetJump] = offset >> 8;
+        font.data[targetJump + 1] = offset & 0xFF;
+        font.data[targetJump + 2] = columns * raster;
+        offset += columns * raster;
+    }
+    return font;
+}
+
+/*
+  ArialMT fonts ship with the ThingPulse library which is not available
+  on the host. Lato_Bold_8 scaled to the ArialMT heights stands in, glyph
+  shapes differ but every size is a font of its own with about the real
+  metrics, so text takes as much room on screen and in the glyph atlas.
+  Generated by the compiler like the real ones are constant data, sizes
+  as the ThingPulse fonts declare them
+*/
+static constexpr nativeFont_t NATIVE_FONT_10 = nativeScaleFont(Lato_Bold_8, 10, 13);
+static constexpr nativeFont_t NATIVE_FONT_16 = nativeScaleFont(Lato_Bold_8, 16, 19);
+static constexpr nativeFont_t NATIVE_FONT_24 = nativeScaleFont(Lato_Bold_8, 24, 28);
+static constexpr const uint8_t *ArialMT_Plain_10 = NATIVE_FONT_10.data;
+static constexpr const uint8_t *ArialMT_Plain_16 = NATIVE_FONT_16.data;
+static constexpr const uint8_t *ArialMT_Plain_24 = NATIVE_FONT_24.data;
+
+class SSD1306 {
+    public:
+        SSD1306(uint8_t address, int sda, int scl);
+        bool init();
+        void clear();
+        void display();
+        void setFont(const char *fontData);
+        void setFont(const uint8_t *fontData);
+        void setPixel(int16_t x, int16_t y);
+        void drawString(int16_t x, int16_t y, const String &text);
+        void drawCircle(int16_t x, int16_t y, int16_t radius);
+        void drawHorizontalLine(int16_t x, int16_t y, int16_t length);
+        uint16_t getStringWidth(const String &text);
+
+        // RAM is kept while the panel is off, pixels still read back
+        bool getPanelPixel(int16_t x, int16_t y);
+        bool isPanelOn() { return _panelOn; }
+        uint8_t getPanelContrast() { return _contrast; }
+        uint32_t getFlushCount() { return _flushCount; }
+
+        uint8_t buffer[DISPLAY_BUFFER_SIZE];
+    private:
+        static void panelWrite(void *context, const uint8_t *data, size_t size);
+        void panelCommand(uint8_t command);
+        void panelData(uint8_t data);
+        uint8_t drawChar(int16_t x, int16_t y, uint8_t c);
+        uint8_t _address;
+        const uint8_t *_font = nullptr;
+        uint32_t _flushCount = 0;
+
+        // Controller state
+        uint8_t _panel[DISPLAY_BUFFER_SIZE];
+        uint8_t _pendingArgs = 0;
+        uint8_t _lastCommand = 0;
+        uint8_t _argIndex = 0;
+        uint8_t _columnStart = 0;
+        uint8_t _columnEnd = DISPLAY_WIDTH - 1;
+        uint8_t _pageStart = 0;
+        uint8_t _pageEnd = DISPLAY_HEIGHT / 8 - 1;
+        uint8_t _column = 0;
+        uint8_t _page = 0;
+        // As the ThingPulse init() leaves them
+        bool _panelOn = true;
+        uint8_t _contrast = 0xCF;
+};
+
+#endif
@@ -0,0 +1,39 @@
+/*
+  TwoWire stand-in for the native host build. Writes are delivered to the
+  simulated peripheral registered at the address, see native_sim.h
+*/
+#pragma once
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+    public:
+        TwoWire(uint8_t busNum) : _busNum(busNum) {}
+        bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+            (void)sda;
+            (void)scl;
+            (void)frequency;
+            return true;
+        }
+        bool setClock(uint32_t frequency) { _clock = frequency; return true; }
+        uint32_t getClock() { return _clock; }
+        void beginTransmission(uint8_t address);
+        size_t write(uint8_t data);
+        size_t write(const uint8_t *data, size_t size);
+        uint8_t endTransmission(bool sendStop = true);
+    private:
+        uint8_t _busNum;
+        uint32_t _clock = 100000;
+        uint8_t _address = 0;
+        uint8_t _txBuffer[I2C_BUFFER_LENGTH];
+        size_t _txLength = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
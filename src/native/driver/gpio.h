@@ -0,0 +1,27 @@
+/*
+  GPIO driver stand-in for the native host build, only the light sleep
+  wakeup calls. Button levels come from the scripted presses
+*/
+#pragma once
+
+#ifndef NATIVE_DRIVER_GPIO_H
+#define NATIVE_DRIVER_GPIO_H
+
+#include "../Arduino.h"
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t type);
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type);
+
+#endif
@@ -0,0 +1,92 @@
+#ifdef NATIVE_BUILD
+
+#include "esp_partition.h"
+#include "native_sim.h"
+
+typedef struct simPartition_s {
+    esp_partition_t partition;
+    uint8_t *data;
+    uint32_t eraseCount;
+} simPartition_t;
+
+// Same custom data partitions as partitions.csv
+static simPartition_t simPartitions[] = {
+    {{ESP_PARTITION_TYPE_DATA, 0x40, 0x290000, 0x4000, "settings"}, nullptr, 0},
+};
+
+static simPartition_t *simFindPartition(const esp_partition_t *partition) {
+    for (simPartition_t &candidate : simPartitions) {
+        if (&candidate.partition == partition) {
+            if (candidate.data == nullptr) {
+                // Fresh chips come erased
+                candidate.data = (uint8_t *)malloc(candidate.partition.size);
+                memset(candidate.data, 0xFF, candidate.partition.size);
+            }
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+    for (simPartition_t &candidate : simPartitions) {
+        if (candidate.partition.type != type) {
+            continue;
+        }
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && candidate.partition.subtype != subtype) {
+            continue;
+        }
+        if (label != nullptr && strcmp(candidate.partition.label, label) != 0) {
+            continue;
+        }
+        return &candidate.partition;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t srcOffset, void *dst, size_t size) {
+    simPartition_t *sim = simFindPartition(partition);
+
+    if (sim == nullptr || srcOffset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, sim->data + srcOffset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dstOffset, const void *src, size_t size) {
+    simPartition_t *sim = simFindPartition(partition);
+
+    if (sim == nullptr || dstOffset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < size; i++) {
+        sim->data[dstOffset + i] &= ((const uint8_t *)src)[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    simPartition_t *sim = simFindPartition(partition);
+
+    if (sim == nullptr || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(sim->data + offset, 0xFF, size);
+    sim->eraseCount += size / SPI_FLASH_SEC_SIZE;
+    return ESP_OK;
+}
+
+uint32_t simGetFlashErases(const char *label) {
+    for (simPartition_t &candidate : simPartitions) {
+        if (strcmp(candidate.partition.label, label) == 0) {
+            return candidate.eraseCount;
+        }
+    }
+    return 0;
+}
+
+#endif
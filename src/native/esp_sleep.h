@@ -0,0 +1,17 @@
+/*
+  esp_sleep stand-in for the native host build. Light sleep moves
+  simulated time forward until the timer expires or a wakeup pin reads
+  low, see native_sim.h
+*/
+#pragma once
+
+#ifndef NATIVE_ESP_SLEEP_H
+#define NATIVE_ESP_SLEEP_H
+
+#include "Arduino.h"
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_err_t esp_light_sleep_start();
+
+#endif
@@ -0,0 +1,244 @@
+#ifdef NATIVE_BUILD
+
+/*
+  Host benchmarks, run with: .pio/build/native/program bench. The firmware
+  suite in benchmark.cpp runs first, then the host only comparisons
+*/
+
+#include "native_bench.h"
+#include "../exposure.h"
+#include "../lux_filter.h"
+#include "../flicker.h"
+#include "../measurement.h"
+#include "../benchmark.h"
+#include "../light_sensor.h"
+#include "native_sim.h"
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLE_COUNTER 1
+#endif
+
+#define BENCH_SAMPLE_COUNT 256
+#define BENCH_ITERATIONS 200000
+
+#define FILTER_TRACE_LENGTH 64
+#define FILTER_STEP_FROM 100.0f
+
+// Keeps the compiler from dropping benchmarked work
+static volatile float benchSink;
+
+static uint64_t benchNow() {
+#ifdef BENCH_HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static const char *benchUnit() {
+#ifdef BENCH_HAS_CYCLE_COUNTER
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+/*
+  Float exposure math as it was in lightSensorTaskHandler and the aperture
+  page renderer before the table driven solver, in steps of the increment
+*/
+static float referenceSolve(float lux, const settings_t &settings) {
+    const float steps = STOP_STEPS_PER_STOP[settings.stopIncrement];
+    const float reflectedEv = log2(lux) + 3;
+    const float incidentEv = log2(lux / 2.5f);
+    float ev = (settings.type == LIGHT_METER_TYPE_REFLECTED) ? reflectedEv : incidentEv;
+
+    ev += settings.isoIndex / steps;
+    ev -= settings.ndFilterIndex;
+
+    const float shutter = pow(2, -settings.shutterIndex / steps);
+    const float aperture = sqrt(shutter * pow(2, ev));
+
+    const float fStop = 2.0 * log2(aperture);
+    const float roundedFStop = round(fStop * steps) / steps;
+    return pow(2.0, roundedFStop / 2.0);
+}
+
+static float solverSolve(float lux, const settings_t &settings) {
+    exposureResult_t result;
+    exposureSolve(lux, settings, &result);
+    return stopEntry(STOP_QUANTITY_APERTURE, settings.stopIncrement, result.outputSteps).value;
+}
+
+static void benchExposure() {
+    float samples[BENCH_SAMPLE_COUNT];
+    settings_t settings;
+
+    // Log spaced 0.1 lux - 100 klux, the VEML7700 useful range
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        samples[i] = 0.1f * powf(10.0f, 6.0f * i / BENCH_SAMPLE_COUNT);
+    }
+
+    uint64_t start = benchNow();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        benchSink = referenceSolve(samples[i % BENCH_SAMPLE_COUNT], settings);
+    }
+    const double reference = (double)(benchNow() - start) / BENCH_ITERATIONS;
+
+    start = benchNow();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        benchSink = solverSolve(samples[i % BENCH_SAMPLE_COUNT], settings);
+    }
+    const double solver = (double)(benchNow() - start) / BENCH_ITERATIONS;
+
+    // Both paths must agree to the displayed precision
+    int mismatches = 0;
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        const float expected = referenceSolve(samples[i], settings);
+        if (expected < 0.5f || expected > 32.0f) {
+            continue;
+        }
+        if (lroundf(expected * 10.0f) != lroundf(solverSolve(samples[i], settings) * 10.0f)) {
+            mismatches++;
+        }
+    }
+
+    printf("exposure_solve reference=%.1f solver=%.1f unit=%s mismatches=%d\n",
+           reference, solver, benchUnit(), mismatches);
+}
+
+// Counts to EV of a sample, float lux and log2f against the fixed point path
+static void benchFixedEv() {
+    const lightSensorRange_t &range = LightSensor::getRange(0);
+    settings_t settings;
+    exposureResult_t result;
+    uint16_t counts[BENCH_SAMPLE_COUNT];
+
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        counts[i] = 1 + i * 255;
+    }
+
+    uint64_t start = benchNow();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        exposureSolve(LightSensor::countsToLux(counts[i % BENCH_SAMPLE_COUNT], 0), settings, &result);
+        benchSink = result.outputSteps;
+    }
+    const double floatPath = (double)(benchNow() - start) / BENCH_ITERATIONS;
+
+    start = benchNow();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        exposureSolveFixed(LightSensor::countsToLog2Lux(counts[i % BENCH_SAMPLE_COUNT], range.gain, range.integrationTime),
+                           settings, &result);
+        benchSink = result.outputSteps;
+    }
+    const double fixedPath = (double)(benchNow() - start) / BENCH_ITERATIONS;
+
+    printf("ev_from_counts float=%.1f fixed=%.1f unit=%s\n", floatPath, fixedPath, benchUnit());
+}
+
+typedef struct filterCase_s {
+    const char *name;
+    uint8_t type;
+    uint8_t samples;
+} filterCase_t;
+
+static const filterCase_t FILTER_CASES[] = {
+    {"none", LUX_FILTER_NONE, 1},
+    {"ema2", LUX_FILTER_EMA, 2},
+    {"ema8", LUX_FILTER_EMA, 8},
+    {"median5", LUX_FILTER_MEDIAN, 5},
+    {"median15", LUX_FILTER_MEDIAN, 15}
+};
+
+/*
+  Synthetic trace: 100 lux with +-10% deterministic noise, the kind of
+  jitter sampling a mains powered light at 4 Hz produces
+*/
+static float filterNoisyLux(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return FILTER_STEP_FROM * (0.9f + 0.2f * (*state >> 8) / (float)(1 << 24));
+}
+
+static void benchLuxFilter() {
+    int32_t trace[FILTER_TRACE_LENGTH];
+    uint32_t state = 1;
+
+    for (int i = 0; i < FILTER_TRACE_LENGTH; i++) {
+        trace[i] = lroundf(log2f(filterNoisyLux(&state)) * EXPOSURE_FIXED_ONE);
+    }
+
+    for (const filterCase_t &filterCase : FILTER_CASES) {
+        LuxFilter filter;
+        filter.configure(filterCase.type, filterCase.samples);
+
+        const uint64_t start = benchNow();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            benchSink = filter.update(trace[i % FILTER_TRACE_LENGTH]);
+        }
+        const double perUpdate = (double)(benchNow() - start) / BENCH_ITERATIONS;
+
+        printf("lux_filter name=%s update=%.1f unit=%s\n", filterCase.name, perUpdate, benchUnit());
+    }
+}
+
+// Sensor samples of a modulated scene, each averaged over its 25ms window
+static void flickerTrace(FlickerAnalyzer *analyzer, float frequencyHz, float depth) {
+    simSetLux(1000.0f);
+    simSetFlicker(frequencyHz, depth);
+
+    analyzer->reset();
+    for (uint32_t i = 0; i < FLICKER_SAMPLE_COUNT; i++) {
+        const uint32_t start = 1000 + i * FLICKER_SAMPLE_PERIOD_MS;
+        analyzer->addSample(lroundf(simGetAverageLux(start, start + FLICKER_SAMPLE_PERIOD_MS) * 10));
+    }
+
+    simSetFlicker(0, 0);
+}
+
+static void benchFlicker() {
+    FlickerAnalyzer analyzer;
+    flickerResult_t result;
+    const int iterations = BENCH_ITERATIONS / 100;
+    uint64_t total = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        flickerTrace(&analyzer, 8.0f, 0.3f);
+
+        const uint64_t start = benchNow();
+        analyzer.analyze(&result);
+        total += benchNow() - start;
+    }
+
+    printf("flicker_analyze samples=%d bins=%d analyze=%.1f unit=%s\n",
+           FLICKER_SAMPLE_COUNT, FLICKER_BIN_COUNT - 1, (double)total / iterations, benchUnit());
+}
+
+extern Benchmark benchmark;
+
+void benchRun() {
+    uint32_t nextUpdate = 0;
+
+    setup();
+
+    // Let auto-ranging settle, on the target the suite runs long after boot
+    simSetLux(300.0f);
+    while (millis() < 3000) {
+        if (millis() >= nextUpdate) {
+            nextUpdate = millis() + lightSensorUpdate();
+        }
+        simAdvanceMillis(1);
+    }
+
+    // Same suite as the "b" Serial command on the target
+    benchmark.run();
+
+    benchExposure();
+    benchFixedEv();
+    benchLuxFilter();
+    benchFlicker();
+}
+
+#endif
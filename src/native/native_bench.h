@@ -0,0 +1,13 @@
+#pragma once
+
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#include "Arduino.h"
+
+void benchRun();
+
+// Sensor task step from main.cpp, returns the time until the next one
+uint32_t lightSensorUpdate();
+
+#endif
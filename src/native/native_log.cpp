@@ -0,0 +1,106 @@
+#ifdef NATIVE_BUILD
+
+#include "native_log.h"
+#include "../measurement_log.h"
+#include "../exposure.h"
+#include "../labels.h"
+
+static const char *const MODE_NAMES[] = {"aperture", "shutter", "iso", "nd", "flicker"};
+
+static const char *const INCREMENT_NAMES[] = {"1", "1/2", "1/3"};
+
+// VEML7700 gain register value to gain
+static const char *const GAIN_NAMES[] = {"1", "2", "0.125", "0.25"};
+
+/*
+  Accepts a raw log or a Serial capture, in which case the records are
+  taken from between the "LOG BEGIN <bytes>" line and "LOG END"
+*/
+bool logPayload(const std::vector<uint8_t> &capture, size_t *offset, size_t *size) {
+    static const char begin[] = "LOG BEGIN ";
+    const size_t beginLength = sizeof(begin) - 1;
+
+    *offset = 0;
+    *size = capture.size();
+
+    for (size_t i = 0; i + beginLength <= capture.size(); i++) {
+        if (memcmp(&capture[i], begin, beginLength) != 0) {
+            continue;
+        }
+
+        size_t position = i + beginLength;
+        unsigned long bytes = 0;
+        while (position < capture.size() && capture[position] >= '0' && capture[position] <= '9') {
+            bytes = bytes * 10 + (capture[position++] - '0');
+        }
+        if (position >= capture.size() || capture[position] != '\n' || position + 1 + bytes > capture.size()) {
+            return false;
+        }
+
+        *offset = position + 1;
+        *size = bytes;
+        return true;
+    }
+
+    return true;
+}
+
+uint32_t logWriteCsv(const uint8_t *data, size_t size, FILE *out) {
+    measurementLogEntry_t entry = {};
+    uint32_t samples = 0;
+
+    fprintf(out, "time_ms,boot,counts,gain,integration_ms,ev,iso,aperture,shutter,nd,type,mode,increment\n");
+
+    for (size_t i = 0; i + MEASUREMENT_LOG_RECORD_SIZE <= size; i += MEASUREMENT_LOG_RECORD_SIZE) {
+        if (MeasurementLog::decodeRecord(data + i, &entry) != MEASUREMENT_LOG_RECORD_SAMPLE) {
+            continue;
+        }
+
+        const settings_t &settings = entry.settings;
+        const uint8_t mode = settings.mode < LIGHT_METER_MODE_COUNT ? settings.mode : 0;
+
+        const uint8_t increment = settings.stopIncrement < STOP_INCREMENT_COUNT ? settings.stopIncrement : 0;
+
+        fprintf(out, "%lu,%d,%u,%s,%u,%.2f,%s,%s,%s,%u,%s,%s,%s\n",
+                (unsigned long)entry.timestamp, entry.boot ? 1 : 0, entry.counts, GAIN_NAMES[entry.gain & 0x03],
+                entry.integrationTimeMs, entry.ev, stopEntry(STOP_QUANTITY_ISO, increment, settings.isoIndex).label,
+                stopEntry(STOP_QUANTITY_APERTURE, increment, settings.apertureIndex).label,
+                stopEntry(STOP_QUANTITY_SHUTTER, increment, settings.shutterIndex).label,
+                (unsigned int)exposureNdFactor(settings.ndFilterIndex), TYPE_TABLE[settings.type & 0x01], MODE_NAMES[mode],
+                INCREMENT_NAMES[increment]);
+
+        // Boot only marks the first sample of a session
+        entry.boot = false;
+        samples++;
+    }
+
+    return samples;
+}
+
+int logDecodeRun(const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (in == nullptr) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+
+    std::vector<uint8_t> capture;
+    uint8_t buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0) {
+        capture.insert(capture.end(), buf, buf + got);
+    }
+    fclose(in);
+
+    size_t offset;
+    size_t size;
+    if (!logPayload(capture, &offset, &size)) {
+        fprintf(stderr, "truncated log dump\n");
+        return 1;
+    }
+
+    logWriteCsv(capture.data() + offset, size, stdout);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#ifndef NATIVE_LOG_H
+#define NATIVE_LOG_H
+
+#include "Arduino.h"
+#include <vector>
+
+/*
+  Host side of the measurement log: decode writes a captured Serial dump
+  or a raw log file as CSV
+*/
+int logDecodeRun(const char *path);
+
+/*
+  Finds the records in a Serial capture, between the "LOG BEGIN <bytes>"
+  line and "LOG END", or takes all of it as a raw log. False when the
+  dump is cut short
+*/
+bool logPayload(const std::vector<uint8_t> &capture, size_t *offset, size_t *size);
+
+// Writes the sample records as CSV lines, returns how many
+uint32_t logWriteCsv(const uint8_t *data, size_t size, FILE *out);
+
+#endif
@@ -0,0 +1,194 @@
+// Test suites under test/ bring their own main()
+#if defined(NATIVE_BUILD) && !defined(PIO_UNIT_TESTING)
+
+/*
+  Native host runner. Replays a scripted session against the simulated
+  sensor, buttons and display: the light sensor task is stepped at the
+  period it asks for and loop() runs once per simulated millisecond,
+  unless it light slept through some of them
+*/
+
+#include "Arduino.h"
+#include "SSD1306.h"
+#include "EEPROM.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "native_log.h"
+#include "../types.h"
+#include "../oled_display.h"
+#include "../settings_store.h"
+#include "../light_sensor.h"
+#include "../measurement_log.h"
+#include "../stage_timing.h"
+#include "../power_manager.h"
+#include "../i2c_arbiter.h"
+#include "../boot_timing.h"
+
+#define NATIVE_SESSION_MS 100000
+
+extern SSD1306 display;
+extern OledDisplay oledDisplay;
+extern SettingsStore settingsStore;
+extern LightSensor lightSensor;
+extern MeasurementLog measurementLog;
+extern settings_t settings;
+extern PowerManager powerManager;
+
+static void dumpPanel() {
+    for (int16_t y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int16_t x = 0; x < DISPLAY_WIDTH; x++) {
+            putchar(display.getPanelPixel(x, y) ? '#' : '.');
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        benchRun();
+        return 0;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "decode") == 0) {
+        return logDecodeRun(argv[2]);
+    }
+
+    // Dim interior, then a window opens
+    simSetLux(80.0f);
+
+    // Right: ISO up 1/3 stop, Down + Right: shutter 1/3 stop faster, Mode long press: shutter mode
+    simScheduleButtonPress(27, 1000, 100);
+    simScheduleButtonPress(12, 2000, 100);
+    simScheduleButtonPress(27, 2500, 100);
+    simScheduleButtonPress(26, 4000, 1200);
+
+    // Scroll the aperture up 11 thirds and back, coalesced into a single save
+    simScheduleButtonPress(12, 5500, 100);
+    for (uint32_t i = 0; i < 22; i++) {
+        simScheduleButtonPress((i < 11) ? 27 : 14, 5800 + i * 150, 80);
+    }
+
+    // Up long press: full stops
+    simScheduleButtonPress(13, 9100, 1200);
+
+    // Mode long presses: ISO mode in the dim studio, ND mode, then flicker mode under a beating LED panel
+    simScheduleButtonPress(26, 10600, 1200);
+    simScheduleButtonPress(26, 11900, 1200);
+    simScheduleButtonPress(26, 13200, 1200);
+
+    /*
+      Mode short press: presets page, Down long press stores preset A, Right
+      selects B. Back on the flicker page one shutter step slower is stored
+      as B, Left switches back to A without a settings write
+    */
+    simScheduleButtonPress(26, 14600, 100);
+    simScheduleButtonPress(12, 14800, 1200);
+    simScheduleButtonPress(27, 16200, 100);
+    simScheduleButtonPress(26, 16400, 100);
+    simScheduleButtonPress(14, 16600, 100);
+    simScheduleButtonPress(26, 16800, 100);
+    simScheduleButtonPress(12, 17000, 1200);
+    simScheduleButtonPress(14, 18400, 100);
+
+    /*
+      Hold short presses freeze a reading before and after the light drops,
+      Left goes back to the first one to mark it as key, Right and Down mark
+      the second one as fill
+    */
+    simScheduleButtonPress(0, 18600, 100);
+    simScheduleButtonPress(0, 20900, 100);
+    simScheduleButtonPress(14, 21100, 100);
+    simScheduleButtonPress(13, 21300, 100);
+    simScheduleButtonPress(27, 21500, 100);
+    simScheduleButtonPress(12, 21700, 100);
+
+    // Hold long press: diagnostics page and back, Mode long press: aperture mode
+    simScheduleButtonPress(0, 22000, 1200);
+    simScheduleButtonPress(0, 23400, 1200);
+    simScheduleButtonPress(26, 24800, 1200);
+
+    /*
+      Left alone the display dims after 20s and turns off after 60s, the
+      sensor goes into power save and the CPU light sleeps between samples.
+      Right wakes it and does nothing else
+    */
+    simScheduleButtonPress(27, 98000, 100);
+
+    setup();
+
+    uint32_t nextSensorUpdate = 0;
+    uint32_t lastSequence = 0;
+
+    for (uint32_t t = millis(); t < NATIVE_SESSION_MS; t = millis()) {
+        if (t == 7000) {
+            simSetLux(2500.0f);
+        } else if (t == 10500) {
+            // Dim studio, exercises auto-ranging
+            simSetLux(3.0f);
+        } else if (t == 12500) {
+            simSetLux(400.0f);
+            simSetFlicker(8.0f, 0.3f);
+        } else if (t == 18800) {
+            // Two stops down, the fill side
+            simSetLux(100.0f);
+        }
+
+        if (t >= nextSensorUpdate) {
+            measurement_t measurement;
+
+            nextSensorUpdate = t + lightSensorUpdate();
+            powerManager.setNextSampleAt(nextSensorUpdate);
+
+            const uint32_t sequence = measurementSnapshot.read(&measurement);
+            if (sequence != lastSequence) {
+                lastSequence = sequence;
+                printf("t=%5lu raw_lux=%8.2f lux=%8.2f counts=%5u range=%u ev=%6.2f mode=%d output=%d flicker=%u depth=%u frame_bytes=%u\n",
+                       (unsigned long)millis(), measurement.rawLux, measurement.lux, measurement.counts, lightSensor.getRangeIndex(),
+                       measurement.ev, measurement.settings.mode, measurement.outputValue, measurement.flicker.frequencyTenths,
+                       measurement.flicker.depthPerMille, oledDisplay.getLastFrameBytes());
+            }
+        }
+
+        loop();
+        simAdvanceMillis(1);
+    }
+
+    printf("light_sensor first_valid_ms=%lu range_changes=%lu\n",
+           (unsigned long)lightSensor.getTimeToFirstValid(),
+           (unsigned long)lightSensor.getRangeChanges());
+    printf("display flush_bytes=%lu i2c_bytes=%lu rendered=%lu skipped=%lu atlas_bytes=%u atlas_glyphs=%u\n",
+           (unsigned long)oledDisplay.getTotalFlushBytes(),
+           (unsigned long)simGetI2cBytes(),
+           (unsigned long)oledDisplay.getRenderedFrames(),
+           (unsigned long)oledDisplay.getSkippedFrames(),
+           oledDisplay.getAtlasBytes(), oledDisplay.getAtlasGlyphs());
+    printf("log records=%lu pages=%lu dropped=%lu\n",
+           (unsigned long)measurementLog.getRecordCount(),
+           (unsigned long)measurementLog.getPageWrites(),
+           (unsigned long)measurementLog.getDroppedRecords());
+    stageTiming.print();
+    i2cArbiter.print();
+    bootTiming.print();
+    printf("settings writes=%lu flash_erases=%lu eeprom_commits=%lu\n",
+           (unsigned long)settingsStore.getWriteCount(),
+           (unsigned long)simGetFlashErases(SETTINGS_STORE_PARTITION),
+           (unsigned long)EEPROM.getCommitCount());
+
+    measurement_t measurement;
+    measurementSnapshot.read(&measurement);
+    printf("presets used=0x%02x active=%u aperture_steps=%d,%d,%d,%d\n", cameraPresets.get().usedMask, cameraPresets.getActive(),
+           measurement.presetOutput[0], measurement.presetOutput[1], measurement.presetOutput[2], measurement.presetOutput[3]);
+
+    powerManager.print();
+    printf("power state=%u light_sleep_ms=%lu cpu_mhz=%lu panel_on=%u contrast=0x%02x\n", powerManager.getState(),
+           (unsigned long)simGetLightSleepMs(), (unsigned long)getCpuFrequencyMhz(), display.isPanelOn(), display.getPanelContrast());
+
+    printf("memory count=%u mean=%d spread=%d ratio=%d\n", measurementMemory.getCount(), measurementMemory.getMean(),
+           measurementMemory.getSpread(), measurementMemory.getRatioHundredths());
+
+    dumpPanel();
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,663 @@
+#ifdef NATIVE_BUILD
+
+#include "native_sim.h"
+#include "EEPROM.h"
+#include "Wire.h"
+#include "Adafruit_VEML7700.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include <vector>
+#include <deque>
+#include <new>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define SIM_SERIAL_FIFO_SIZE 128
+// 115200 baud, 10 bits per byte
+#define SIM_SERIAL_BYTES_PER_MS 11.52f
+
+HardwareSerial Serial;
+TwoWire Wire(0);
+EEPROMClass EEPROM;
+EspClass ESP;
+
+typedef struct buttonPress_s {
+    uint8_t pin;
+    uint32_t startMs;
+    uint32_t endMs;
+} buttonPress_t;
+
+static uint64_t simMicros = 0;
+static float simLux = 100.0f;
+static uint32_t simQueueBlockUntil = 0;
+static float simFlickerHz = 0;
+static float simFlickerDepth = 0;
+static float simSensorScale = 1.0f;
+static float simSensorSlope = 1.0f;
+static bool simSensorPresent = true;
+typedef struct i2cDevice_s {
+    uint8_t address;
+    simI2cWrite_f write;
+    void *context;
+} i2cDevice_t;
+
+typedef struct interrupt_s {
+    uint8_t pin;
+    void (*handler)(void *);
+    void *arg;
+    int level;
+} interrupt_t;
+
+typedef struct queue_s {
+    uint8_t *items;
+    uint32_t length;
+    uint32_t itemSize;
+    uint32_t head;
+    uint32_t count;
+} queue_t;
+
+#define SIM_I2C_DEVICE_COUNT 4
+
+static std::vector<buttonPress_t> simButtonPresses;
+static i2cDevice_t simI2cDevices[SIM_I2C_DEVICE_COUNT];
+static uint8_t simI2cDeviceCount = 0;
+static uint32_t simI2cBytes = 0;
+static std::vector<interrupt_t> simInterrupts;
+
+static float simSerialPending = 0;
+static size_t simSerialTxBuffer = 0;
+static uint32_t simSerialBlockedBytes = 0;
+static bool simSerialCapturing = false;
+static std::deque<uint8_t> simSerialOutput;
+static std::deque<uint8_t> simSerialInput;
+
+static uint32_t simCpuFrequencyMhz = 240;
+static std::vector<gpio_num_t> simWakePins;
+static bool simGpioWakeup = false;
+static uint64_t simSleepTimerUs = 0;
+static uint32_t simLightSleepMs = 0;
+
+static uint32_t simHeapAllocations = 0;
+static size_t simHeapInUse = 0;
+static size_t simHeapPeak = 0;
+
+/*
+  Allocation size is kept in a header in front of the block so frees can
+  be accounted for as well
+*/
+#define SIM_HEAP_HEADER sizeof(max_align_t)
+
+static void *simHeapAllocate(size_t size) {
+    uint8_t *block = (uint8_t *)malloc(size + SIM_HEAP_HEADER);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *(size_t *)block = size;
+
+    simHeapAllocations++;
+    simHeapInUse += size;
+    if (simHeapInUse > simHeapPeak) {
+        simHeapPeak = simHeapInUse;
+    }
+    return block + SIM_HEAP_HEADER;
+}
+
+static void simHeapFree(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    uint8_t *block = (uint8_t *)ptr - SIM_HEAP_HEADER;
+    simHeapInUse -= *(size_t *)block;
+    free(block);
+}
+
+void *operator new(size_t size) { return simHeapAllocate(size); }
+void *operator new[](size_t size) { return simHeapAllocate(size); }
+void operator delete(void *ptr) noexcept { simHeapFree(ptr); }
+void operator delete[](void *ptr) noexcept { simHeapFree(ptr); }
+void operator delete(void *ptr, size_t size) noexcept { (void)size; simHeapFree(ptr); }
+void operator delete[](void *ptr, size_t size) noexcept { (void)size; simHeapFree(ptr); }
+
+uint32_t simGetHeapAllocations() {
+    return simHeapAllocations;
+}
+
+size_t simGetHeapInUse() {
+    return simHeapInUse;
+}
+
+size_t simGetHeapPeak() {
+    return simHeapPeak;
+}
+
+// Fires CHANGE interrupts for pins whose simulated level moved
+static void simDispatchInterrupts() {
+    for (interrupt_t &interrupt : simInterrupts) {
+        const int level = digitalRead(interrupt.pin);
+        if (level != interrupt.level) {
+            interrupt.level = level;
+            interrupt.handler(interrupt.arg);
+        }
+    }
+}
+
+void simAdvanceMillis(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        simMicros += 1000;
+        simSerialPending = (simSerialPending > SIM_SERIAL_BYTES_PER_MS) ? simSerialPending - SIM_SERIAL_BYTES_PER_MS : 0;
+        simDispatchInterrupts();
+    }
+}
+
+void simSetLux(float lux) {
+    simLux = lux;
+}
+
+float simGetLux() {
+    return simLux;
+}
+
+size_t simSerialWrite(const uint8_t *buf, size_t size) {
+    const int room = simSerialAvailableForWrite();
+    if ((int)size > room) {
+        simSerialBlockedBytes += size - room;
+    }
+    simSerialPending += size;
+
+    if (simSerialCapturing) {
+        simSerialOutput.insert(simSerialOutput.end(), buf, buf + size);
+    } else {
+        fwrite(buf, 1, size, stdout);
+    }
+    return size;
+}
+
+int simSerialAvailableForWrite() {
+    const float capacity = SIM_SERIAL_FIFO_SIZE + simSerialTxBuffer;
+    return (simSerialPending >= capacity) ? 0 : capacity - (int)ceilf(simSerialPending);
+}
+
+void simSerialSetTxBufferSize(size_t size) {
+    simSerialTxBuffer = size;
+}
+
+int simSerialAvailable() {
+    return simSerialInput.size();
+}
+
+int simSerialRead() {
+    if (simSerialInput.empty()) {
+        return -1;
+    }
+    const uint8_t c = simSerialInput.front();
+    simSerialInput.pop_front();
+    return c;
+}
+
+void simSerialCapture(bool enabled) {
+    simSerialCapturing = enabled;
+}
+
+size_t simSerialCaptured(uint8_t *buf, size_t size) {
+    size_t count = 0;
+    while (count < size && !simSerialOutput.empty()) {
+        buf[count++] = simSerialOutput.front();
+        simSerialOutput.pop_front();
+    }
+    return count;
+}
+
+void simSerialInject(const uint8_t *data, size_t size) {
+    simSerialInput.insert(simSerialInput.end(), data, data + size);
+}
+
+uint32_t simGetSerialBlockedBytes() {
+    return simSerialBlockedBytes;
+}
+
+void simSetFlicker(float frequencyHz, float depth) {
+    simFlickerHz = frequencyHz;
+    simFlickerDepth = depth;
+}
+
+float simGetAverageLux(uint32_t startMs, uint32_t endMs) {
+    if (simFlickerDepth == 0 || simFlickerHz == 0 || endMs <= startMs) {
+        return simLux;
+    }
+
+    // Integral of the sine over the window, in closed form
+    const double omega = 2 * M_PI * simFlickerHz;
+    const double start = startMs / 1000.0;
+    const double end = endMs / 1000.0;
+    const double average = (cos(omega * start) - cos(omega * end)) / (omega * (end - start));
+
+    return simLux * (1 + simFlickerDepth * average);
+}
+
+void simSetSensorPresent(bool present) {
+    simSensorPresent = present;
+}
+
+bool simIsSensorPresent() {
+    return simSensorPresent;
+}
+
+void simScheduleButtonPress(uint8_t pin, uint32_t startMs, uint32_t durationMs) {
+    simButtonPresses.push_back({pin, startMs, startMs + durationMs});
+}
+
+void simRegisterI2cDevice(uint8_t address, simI2cWrite_f write, void *context) {
+    if (simI2cDeviceCount < SIM_I2C_DEVICE_COUNT) {
+        simI2cDevices[simI2cDeviceCount++] = {address, write, context};
+    }
+}
+
+bool simI2cWrite(uint8_t address, const uint8_t *data, size_t size) {
+    simI2cBytes += 1 + size;
+
+    for (uint8_t i = 0; i < simI2cDeviceCount; i++) {
+        if (simI2cDevices[i].address == address) {
+            simI2cDevices[i].write(simI2cDevices[i].context, data, size);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t simGetI2cBytes() {
+    return simI2cBytes;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength >= I2C_BUFFER_LENGTH) {
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size) {
+    size_t written = 0;
+    while (written < size && write(data[written])) {
+        written++;
+    }
+    return written;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    // 2 is the Arduino code for address NACK
+    return simI2cWrite(_address, _txBuffer, _txLength) ? 0 : 2;
+}
+
+uint32_t millis() {
+    return (uint32_t)(simMicros / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)simMicros;
+}
+
+void delay(uint32_t ms) {
+    simAdvanceMillis(ms);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    (void)pin;
+    (void)value;
+}
+
+int digitalRead(uint8_t pin) {
+    const uint32_t now = millis();
+
+    for (const buttonPress_t &press : simButtonPresses) {
+        if (press.pin == pin && now >= press.startMs && now < press.endMs) {
+            return LOW;
+        }
+    }
+    return HIGH;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {
+    (void)mode;
+    simInterrupts.push_back({pin, handler, arg, digitalRead(pin)});
+}
+
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t itemSize) {
+    queue_t *queue = new queue_t;
+    queue->items = new uint8_t[length * itemSize];
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->head = 0;
+    queue->count = 0;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void *item, TickType_t ticksToWait) {
+    queue_t *queue = (queue_t *)handle;
+    (void)ticksToWait;
+
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    const uint32_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + tail * queue->itemSize, item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+void simBlockQueuesUntil(uint32_t ms) {
+    simQueueBlockUntil = ms;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void *item, TickType_t ticksToWait) {
+    queue_t *queue = (queue_t *)handle;
+    const uint32_t start = millis();
+
+    // Interrupts dispatched while time moves on may post meanwhile
+    while (queue->count == 0 && ticksToWait > 0 && millis() < simQueueBlockUntil &&
+           (ticksToWait == portMAX_DELAY || millis() - start < ticksToWait * portTICK_PERIOD_MS)) {
+        simAdvanceMillis(1);
+    }
+
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items + queue->head * queue->itemSize, queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+uint32_t EspClass::getCycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+TickType_t xTaskGetTickCount() {
+    return millis() / portTICK_PERIOD_MS;
+}
+
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t timeIncrement) {
+    *previousWakeTime += timeIncrement;
+    if (*previousWakeTime > xTaskGetTickCount()) {
+        simAdvanceMillis((*previousWakeTime - xTaskGetTickCount()) * portTICK_PERIOD_MS);
+    }
+}
+
+// Only the native runner steps the sensor task, nothing to wake
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    (void)clearCountOnExit;
+    simAdvanceMillis(ticksToWait * portTICK_PERIOD_MS);
+    return 0;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+}
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+    simCpuFrequencyMhz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return simCpuFrequencyMhz;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t type) {
+    (void)type;
+    simWakePins.push_back(gpio);
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio) {
+    for (size_t i = 0; i < simWakePins.size(); i++) {
+        if (simWakePins[i] == gpio) {
+            simWakePins.erase(simWakePins.begin() + i);
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type) {
+    (void)gpio;
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+    simSleepTimerUs = timeUs;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    simGpioWakeup = true;
+    return ESP_OK;
+}
+
+static bool simWakePinLow() {
+    for (gpio_num_t pin : simWakePins) {
+        if (digitalRead(pin) == LOW) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Wakeup sources stay armed, like on the chip
+esp_err_t esp_light_sleep_start() {
+    const uint32_t start = millis();
+
+    while (millis() - start < simSleepTimerUs / 1000 && !(simGpioWakeup && simWakePinLow())) {
+        simAdvanceMillis(1);
+    }
+    simLightSleepMs += millis() - start;
+    return ESP_OK;
+}
+
+uint32_t simGetLightSleepMs() {
+    return simLightSleepMs;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    (void)task;
+}
+
+void vTaskResume(TaskHandle_t task) {
+    (void)task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth,
+                                   void *parameters, unsigned int priority, TaskHandle_t *createdTask, int coreId) {
+    (void)task;
+    (void)name;
+    (void)stackDepth;
+    (void)parameters;
+    (void)priority;
+    (void)coreId;
+    if (createdTask) {
+        *createdTask = nullptr;
+    }
+    return pdPASS;
+}
+
+bool EEPROMClass::begin(size_t size) {
+    if (size > NATIVE_EEPROM_MAX_SIZE) {
+        return false;
+    }
+    // Erased once, the contents survive a second begin() like they survive a reboot
+    if (_size == 0) {
+        memset(_data, 0xFF, sizeof(_data));
+    }
+    _size = size;
+    return true;
+}
+
+uint8_t EEPROMClass::read(int address) {
+    if (address < 0 || (size_t)address >= _size) {
+        return 0;
+    }
+    return _data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address < 0 || (size_t)address >= _size) {
+        return;
+    }
+    _data[address] = value;
+}
+
+bool EEPROMClass::commit() {
+    _commitCount++;
+    return true;
+}
+
+bool Adafruit_VEML7700::begin(TwoWire *theWire) {
+    (void)theWire;
+    _configuredAt = millis();
+    return simSensorPresent;
+}
+
+void Adafruit_VEML7700::enable(bool enable) {
+    _enabled = enable;
+    _configuredAt = millis();
+}
+
+void Adafruit_VEML7700::setGain(uint8_t gain) {
+    _gain = gain;
+    _configuredAt = millis();
+}
+
+void Adafruit_VEML7700::setIntegrationTime(uint8_t it, bool wait) {
+    _integrationTime = it;
+    _configuredAt = millis();
+    if (wait) {
+        delay(getIntegrationTimeValue() * 2);
+    }
+}
+
+int Adafruit_VEML7700::getIntegrationTimeValue() {
+    switch (_integrationTime) {
+        case VEML7700_IT_25MS: return 25;
+        case VEML7700_IT_50MS: return 50;
+        case VEML7700_IT_200MS: return 200;
+        case VEML7700_IT_400MS: return 400;
+        case VEML7700_IT_800MS: return 800;
+        default: return 100;
+    }
+}
+
+float Adafruit_VEML7700::getGainValue() {
+    switch (_gain) {
+        case VEML7700_GAIN_2: return 2.0f;
+        case VEML7700_GAIN_1_8: return 0.125f;
+        case VEML7700_GAIN_1_4: return 0.25f;
+        default: return 1.0f;
+    }
+}
+
+float Adafruit_VEML7700::getResolution() {
+    return 0.0036f * (800.0f / getIntegrationTimeValue()) * (2.0f / getGainValue());
+}
+
+void Adafruit_VEML7700::powerSaveEnable(bool enable) {
+    _powerSave = enable;
+    _configuredAt = millis();
+}
+
+void Adafruit_VEML7700::setPowerSaveMode(uint8_t mode) {
+    _powerSaveMode = mode & 0x03;
+}
+
+// 500ms for mode 1, doubling up to 4s for mode 4
+uint32_t Adafruit_VEML7700::getPowerSaveWait() {
+    return _powerSave ? 500 << _powerSaveMode : 0;
+}
+
+void simSetSensorError(float scale, float slope) {
+    simSensorScale = scale;
+    simSensorSlope = slope;
+}
+
+static float simVemlCorrection(float lux) {
+    return (((6.0135e-13f * lux - 9.3924e-9f) * lux + 8.1488e-5f) * lux + 1.0023f) * lux;
+}
+
+/*
+  Low gain ranges read low at high illuminance, invert the correction
+  polynomial from the application note by bisection to get what the
+  sensor would report
+*/
+uint16_t Adafruit_VEML7700::convert(float lux) {
+    float reported = lux;
+
+    if (_gain == VEML7700_GAIN_1_8 || _gain == VEML7700_GAIN_1_4) {
+        float low = 0;
+        float high = lux;
+        for (uint8_t i = 0; i < 40; i++) {
+            const float mid = (low + high) / 2;
+            if (simVemlCorrection(mid) < lux) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        reported = low;
+    }
+
+    const float counts = reported / getResolution();
+    return counts >= 65535.0f ? 65535 : (uint16_t)counts;
+}
+
+uint16_t Adafruit_VEML7700::readALS(bool wait) {
+    if (wait) {
+        delay(getIntegrationTimeValue() * 2);
+    }
+    // Until the first conversion in the new configuration completes the old result is read back
+    const uint32_t integrationTime = getIntegrationTimeValue();
+    if (_enabled && millis() - _configuredAt >= integrationTime) {
+        // Conversions run from the configuration change, back to back or with the power save wait between them
+        const uint32_t cycle = integrationTime + getPowerSaveWait();
+        const uint32_t end = _configuredAt + integrationTime + (millis() - _configuredAt - integrationTime) / cycle * cycle;
+        const float lux = simGetAverageLux(end - integrationTime, end);
+        _lastCounts = convert(simSensorScale * powf(lux, simSensorSlope));
+    }
+    return _lastCounts;
+}
+
+float Adafruit_VEML7700::readLux(luxMethod method) {
+    (void)method;
+    return simLux;
+}
+
+#endif
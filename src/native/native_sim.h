@@ -0,0 +1,88 @@
+/*
+  Simulation controls for the native host build. Time only moves when the
+  runner advances it, so sessions are repeatable
+*/
+#pragma once
+
+#ifndef NATIVE_SIM_H
+#define NATIVE_SIM_H
+
+#include "Arduino.h"
+
+
+void simAdvanceMillis(uint32_t ms);
+void simSetLux(float lux);
+float simGetLux();
+/*
+  Sine modulation of the scene, lux * (1 + depth * sin(2 pi f t)). The
+  VEML7700 stand-in averages it over each integration window like the
+  real sensor. Depth 0 turns it off
+*/
+void simSetFlicker(float frequencyHz, float depth);
+float simGetAverageLux(uint32_t startMs, uint32_t endMs);
+/*
+  Response error of the simulated VEML7700, it reports scale * lux^slope
+  for a scene of lux. 1, 1 is an ideal part
+*/
+void simSetSensorError(float scale, float slope);
+void simSetSensorPresent(bool present);
+bool simIsSensorPresent();
+
+/*
+  Simulated I2C peripherals. Every TwoWire transmission is delivered to the
+  device registered at its address and counted, address byte included
+*/
+typedef void (*simI2cWrite_f)(void *context, const uint8_t *data, size_t size);
+
+void simRegisterI2cDevice(uint8_t address, simI2cWrite_f write, void *context);
+bool simI2cWrite(uint8_t address, const uint8_t *data, size_t size);
+uint32_t simGetI2cBytes();
+
+/*
+  Heap accounting: every global operator new is counted, so a block of code
+  can be checked for allocations by comparing the counter around it
+*/
+uint32_t simGetHeapAllocations();
+size_t simGetHeapInUse();
+size_t simGetHeapPeak();
+
+// Sector erases done on a simulated flash partition so far
+uint32_t simGetFlashErases(const char *label);
+
+/*
+  Queue receives with a timeout only wait in simulated time up to ms, where
+  the runner has the other task to step. 0, the default, makes every
+  receive return at once
+*/
+void simBlockQueuesUntil(uint32_t ms);
+
+/*
+  Serial port at 115200 baud: the 128 byte TX FIFO, plus the driver ring
+  buffer set with setTxBufferSize, drains with simulated time. Output goes
+  to stdout unless captured, bytes written while it is full are counted,
+  on the target those writes would block
+*/
+void simSerialCapture(bool enabled);
+size_t simSerialCaptured(uint8_t *buf, size_t size);
+void simSerialInject(const uint8_t *data, size_t size);
+uint32_t simGetSerialBlockedBytes();
+
+// Preferences put, remove and clear calls so far
+uint32_t simGetNvsWrites();
+
+// LittleFS write calls and bytes so far
+uint32_t simGetFsWrites();
+uint32_t simGetFsWriteBytes();
+
+/*
+  Light sleep stands still inside esp_light_sleep_start(): simulated time
+  moves on until the wakeup timer or a wakeup pin, loop() returns after it
+*/
+uint32_t simGetLightSleepMs();
+
+/*
+  Schedules a button press: pin is pulled LOW at startMs for durationMs
+*/
+void simScheduleButtonPress(uint8_t pin, uint32_t startMs, uint32_t durationMs);
+
+#endif
@@ -2,8 +2,68 @@
 #include "Arduino.h"
 #include "types.h"
 #include "Lato_Bold_8.h"
-
-OledDisplay::OledDisplay(SSD1306 *display) {
+#include "exposure.h"
+#include "labels.h"
+#include "stage_timing.h"
+
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+// Diagnostics page columns: stage, min, p50, p99, max
+static const uint8_t DIAGNOSTICS_COLUMNS[] = {0, 30, 54, 78, 102};
+
+/*
+  Every text position the meter pages draw at, with the characters it can
+  show. Rows sharing y % 8 share a set, anything else takes the font path
+*/
+static constexpr char ATLAS_NUMBERS[] = "0123456789.-/";
+
+static constexpr glyphAtlasText_t ATLAS_TEXTS[] = {
+    // Aperture, shutter and flicker readouts, EV
+    {ArialMT_Plain_24, 0, ATLAS_NUMBERS},
+    {ArialMT_Plain_24, 0, "f\"k-lowhigSteadyHzKN"},
+    {ArialMT_Plain_16, 48, ATLAS_NUMBERS},
+    {ArialMT_Plain_16, 0, "f-lowhig"},
+    {Lato_Bold_8, 54, "EV"},
+
+    // Right column values
+    {ArialMT_Plain_10, 9, ATLAS_NUMBERS},
+    {ArialMT_Plain_10, 9, "Kk%"},
+    {ArialMT_Plain_10, 31, ATLAS_NUMBERS},
+    {ArialMT_Plain_10, 31, "k"},
+    {ArialMT_Plain_10, 53, ATLAS_NUMBERS},
+    {ArialMT_Plain_10, 53, "NDonek%"},
+
+    // Fixed labels
+    {Lato_Bold_8, 0, "ISODepthShutter"},
+    {Lato_Bold_8, 22, "ShutterAperture"},
+    {Lato_Bold_8, 28, "ISO"},
+    {Lato_Bold_8, 44, "ND FilterAt shutterS"},
+    {Lato_Bold_8, 38, "IncidentReflectedIndex 0.123456789"},
+
+    // Presets page settings line
+    {Lato_Bold_8, 19, ATLAS_NUMBERS},
+    {Lato_Bold_8, 19, " kND"},
+
+    // Memory page
+    {Lato_Bold_8, 0, "Mean"},
+    {Lato_Bold_8, 22, "Spread"},
+    {Lato_Bold_8, 28, "EV /0123456789KeyFil"},
+    {Lato_Bold_8, 44, "Key:Fil"},
+    {Lato_Bold_8, 38, "MinMax-"},
+    {ArialMT_Plain_10, 53, ":"}
+};
+
+// Generated twice by the compiler, once to size the tables, then at that size into flash
+static constexpr glyphAtlasTables_s<GLYPH_ATLAS_SET_COUNT, GLYPH_ATLAS_GLYPH_COUNT, GLYPH_ATLAS_POOL_SIZE> ATLAS_SIZE =
+    glyphAtlasBuild<GLYPH_ATLAS_SET_COUNT, GLYPH_ATLAS_GLYPH_COUNT, GLYPH_ATLAS_POOL_SIZE>(ATLAS_TEXTS);
+static_assert(ATLAS_SIZE.complete, "Glyph atlas text missing from its font or over the atlas limits");
+
+static constexpr glyphAtlasTables_s<ATLAS_SIZE.setCount, ATLAS_SIZE.glyphCount, ATLAS_SIZE.poolUsed> ATLAS =
+    glyphAtlasBuild<ATLAS_SIZE.setCount, ATLAS_SIZE.glyphCount, ATLAS_SIZE.poolUsed>(ATLAS_TEXTS);
+
+OledDisplay::OledDisplay(SSD1306 *display, TwoWire *wire, uint8_t address) : _flush(wire, address), _atlas(ATLAS) {
     _display = display;
 }
 
@@ -12,6 +72,21 @@ void OledDisplay::init() {
     _display->setFont(ArialMT_Plain_10);
 }
 
+// Sends only what changed since the previous frame instead of display()
+void OledDisplay::flush() {
+    const uint32_t flushStart = StageTiming::start();
+    _flush.flush(_display->buffer);
+    stageTiming.stop(TIMING_STAGE_DISPLAY_FLUSH, flushStart);
+}
+
+uint16_t OledDisplay::getLastFrameBytes() {
+    return _flush.getLastFrameBytes();
+}
+
+uint32_t OledDisplay::getTotalFlushBytes() {
+    return _flush.getTotalBytes();
+}
+
 void OledDisplay::loop() {
     page();
 }
@@ -24,6 +99,21 @@ void OledDisplay::setOnlyForcedDisplay(bool onlyForcedDisplay) {
     _onlyForcedDisplay = onlyForcedDisplay;
 }
 
+void OledDisplay::setContrast(uint8_t contrast) {
+    const uint8_t commands[] = {SSD1306_SETCONTRAST, contrast};
+    _flush.command(commands, sizeof(commands));
+}
+
+void OledDisplay::setPanelOn(bool on) {
+    const uint8_t command = on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF;
+
+    _flush.command(&command, 1);
+    _panelOn = on;
+    if (on) {
+        forceDisplay();
+    }
+}
+
 void OledDisplay::setPage(uint8_t page) {
     _page = page;
 }
@@ -40,38 +130,211 @@ void OledDisplay::page() {
 
     bool toDisplay = _forceDisplay || timePassed || lastUpdate == 0;
 
-    if (!toDisplay) {
+    if (!toDisplay || !_panelOn) {
         return;
     }
 
     _forceDisplay = false;
 
+    measurementSnapshot.read(&_measurement);
+    measurementResolve(&_measurement, settings, cameraPresets.get());
+
+    buildView(&_view);
+
+    // Same values as the frame on the panel, it would draw the same pixels
+    const uint32_t viewHash = hashView(_view);
+    if (_viewHashValid && viewHash == _viewHash && _page != OLED_PAGE_DIAGNOSTICS) {
+        _skippedFrames++;
+        lastUpdate = millis();
+        return;
+    }
+    _viewHash = viewHash;
+    _viewHashValid = true;
+    _renderedFrames++;
+
+    const uint32_t renderStart = StageTiming::start();
+
     switch (_page) {
         
         case OLED_PAGE_APERTURE:
             renderPageAperture();
+            stageTiming.stop(TIMING_STAGE_RENDER_APERTURE, renderStart);
             break;
 
         case OLED_PAGE_SHUTTER:
             renderPageShutter();
+            stageTiming.stop(TIMING_STAGE_RENDER_SHUTTER, renderStart);
+            break;
+
+        case OLED_PAGE_ISO:
+            renderPageIso();
+            stageTiming.stop(TIMING_STAGE_RENDER_ISO, renderStart);
+            break;
+
+        case OLED_PAGE_ND:
+            renderPageNd();
+            stageTiming.stop(TIMING_STAGE_RENDER_ND, renderStart);
+            break;
+
+        case OLED_PAGE_FLICKER:
+            renderPageFlicker();
+            stageTiming.stop(TIMING_STAGE_RENDER_FLICKER, renderStart);
+            break;
+
+        case OLED_PAGE_PRESETS:
+            renderPagePresets();
+            stageTiming.stop(TIMING_STAGE_RENDER_PRESETS, renderStart);
+            break;
+
+        case OLED_PAGE_MEMORY:
+            renderPageMemory();
+            stageTiming.stop(TIMING_STAGE_RENDER_MEMORY, renderStart);
+            break;
+
+        case OLED_PAGE_DIAGNOSTICS:
+            renderPageDiagnostics();
             break;
 
         case OLED_PAGE_ERROR:
             _display->clear();
-            _display->setFont(ArialMT_Plain_24);
-            _display->drawString(0, 0, "Error");
-            _display->display();
+            drawText(0, 0, ArialMT_Plain_24, "Error");
             break;
     }
 
+    flush();
+
     lastUpdate = millis();
 }
 
+#define FORMAT_TENTHS_MAX 99999
+
+/*
+  Only what the current page draws goes into the view, rounded the way it
+  is drawn, so changes that don't show on screen keep the hash
+*/
+void OledDisplay::buildView(oledView_t *view) {
+    const settings_t &measured = _measurement.settings;
+
+    memset(view, 0, sizeof(oledView_t));
+    view->page = _page;
+
+    // Pages drawn from the measurement come before the diagnostics page
+    if (_page == OLED_PAGE_NONE || _page >= OLED_PAGE_DIAGNOSTICS) {
+        return;
+    }
+
+    // EV and the stop increment only show on the meter pages, presets and memory keep their own
+    if (_page < OLED_PAGE_PRESETS) {
+        view->evTenths = lroundf(_measurement.ev * 10.0f);
+        view->evWide = _measurement.ev >= 10;
+        view->adjustSetting = measured.adjustSetting;
+        view->increment = (measured.stopIncrement < STOP_INCREMENT_COUNT) ? measured.stopIncrement : (uint8_t)STOP_INCREMENT_FULL;
+    }
+
+    if (_page == OLED_PAGE_APERTURE) {
+        // Solved index is a table index already, out of range values all show the same
+        view->output = outputIndex(STOP_QUANTITY_APERTURE, view->increment);
+        view->isoIndex = measured.isoIndex;
+        view->shutterIndex = measured.shutterIndex;
+        view->ndFilterIndex = measured.ndFilterIndex;
+        view->type = measured.type;
+    } else if (_page == OLED_PAGE_SHUTTER) {
+        view->output = outputIndex(STOP_QUANTITY_SHUTTER, view->increment);
+        view->isoIndex = measured.isoIndex;
+        view->apertureIndex = measured.apertureIndex;
+        view->ndFilterIndex = measured.ndFilterIndex;
+        view->type = measured.type;
+    } else if (_page == OLED_PAGE_ISO) {
+        view->output = outputIndex(STOP_QUANTITY_ISO, view->increment);
+        view->apertureIndex = measured.apertureIndex;
+        view->shutterIndex = measured.shutterIndex;
+        view->ndFilterIndex = measured.ndFilterIndex;
+        view->type = measured.type;
+    } else if (_page == OLED_PAGE_ND) {
+        // Filters come in full stops
+        const int16_t stops = exposureRoundToStops(_measurement.outputValue, STOP_STEPS_PER_STOP[view->increment]);
+        view->output = constrain(stops, ND_FILTER_INDEX_MIN - 1, ND_FILTER_INDEX_MAX + 1);
+        view->isoIndex = measured.isoIndex;
+        view->apertureIndex = measured.apertureIndex;
+        view->shutterIndex = measured.shutterIndex;
+        view->type = measured.type;
+    } else if (_page == OLED_PAGE_PRESETS) {
+        const cameraPresets_t &presets = _measurement.presets;
+        const stopSeries_t &apertures = stopSeries(STOP_QUANTITY_APERTURE, presets.increment);
+
+        view->presets = presets;
+        view->activePreset = cameraPresets.getActive();
+        for (uint8_t i = 0; i < CAMERA_PRESET_COUNT; i++) {
+            if (presets.usedMask & (1 << i)) {
+                view->presetOutput[i] = constrain(_measurement.presetOutput[i], apertures.minIndex - 1, apertures.maxIndex + 1);
+            }
+        }
+    } else if (_page == OLED_PAGE_MEMORY) {
+        // Every statistic is kept up to date by the memory, nothing is summed here
+        const uint8_t cursor = measurementMemory.getCursor();
+
+        view->memoryCount = measurementMemory.getCount();
+        if (view->memoryCount > 0) {
+            view->memoryCursor = cursor;
+            view->memoryKey = measurementMemory.isKey(cursor);
+            view->memoryFill = measurementMemory.isFill(cursor);
+            view->memoryHasRatio = measurementMemory.hasRatio();
+            view->memoryEv = measurementMemory.get(cursor).evHundredths;
+            view->memoryMean = measurementMemory.getMean();
+            view->memoryMin = measurementMemory.getMin();
+            view->memoryMax = measurementMemory.getMax();
+            view->memoryRatio = measurementMemory.getRatioHundredths();
+        }
+    } else {
+        const flickerResult_t &flicker = _measurement.flicker;
+
+        view->shutterIndex = measured.shutterIndex;
+        view->flickerFrequencyTenths = flicker.frequencyTenths;
+        view->flickerDepthPercent = (flicker.depthPerMille + 5) / 10;
+        const float shutterSeconds = stopEntry(STOP_QUANTITY_SHUTTER, view->increment, measured.shutterIndex).value;
+        view->flickerAtShutterPercent = (flickerAtShutter(flicker, shutterSeconds) + 5) / 10;
+        view->flickerIndexHundredths = (flicker.flickerIndex + 5) / 10;
+    }
+}
+
+// Solved index clamped to one past either end of its series
+int16_t OledDisplay::outputIndex(uint8_t quantity, uint8_t increment) {
+    const stopSeries_t &series = stopSeries(quantity, increment);
+    return constrain(_measurement.outputValue, series.minIndex - 1, series.maxIndex + 1);
+}
+
+// FNV-1a, the view is a few bytes and hashed once per frame
+uint32_t OledDisplay::hashView(const oledView_t &view) {
+    const uint8_t *bytes = (const uint8_t *)&view;
+    uint32_t hash = 2166136261UL;
+
+    for (size_t i = 0; i < sizeof(oledView_t); i++) {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+/*
+  Formats a value given in tenths as "-12.3" without going through float
+  printf, newlib's float formatting allocates on first use. Clamped to
+  "-9999.9", which fits every label and no reading gets near
+*/
+static void formatTenths(char *buffer, size_t size, int32_t tenths) {
+    const char *sign = (tenths < 0) ? "-" : "";
+    tenths = constrain(tenths, -FORMAT_TENTHS_MAX, FORMAT_TENTHS_MAX);
+    if (tenths < 0) {
+        tenths = -tenths;
+    }
+    snprintf(buffer, size, "%s%ld.%ld", sign, (long)(tenths / 10), (long)(tenths % 10));
+}
+
 void OledDisplay::renderWidgetEv() {
-    _display->setFont(ArialMT_Plain_16);
-    _display->drawString(4, 48, String(ev, 1));
-    _display->setFont(Lato_Bold_8);
-    _display->drawString((ev >= 10) ? 38:34, 54, "EV");
+    char evLabel[OLED_LABEL_SIZE];
+
+    formatTenths(evLabel, sizeof(evLabel), _view.evTenths);
+
+    drawText(4, 48, ArialMT_Plain_16, evLabel);
+    drawText(_view.evWide ? 38:34, 54, Lato_Bold_8, "EV");
 }
 
 void OledDisplay::renderPageAperture() {
@@ -79,127 +342,354 @@ void OledDisplay::renderPageAperture() {
 
     renderWidgetEv();
 
-    if (settings.adjustSetting == ADJUST_SETTING_ISO) {
+    if (_view.adjustSetting == ADJUST_SETTING_ISO) {
         _display->drawCircle(68, 10, 3);
-    } else if (settings.adjustSetting == ADJUST_SETTING_SHUTTER)  {
+    } else if (_view.adjustSetting == ADJUST_SETTING_SHUTTER)  {
         _display->drawCircle(68, 31, 3);
     } else {
         _display->drawCircle(68, 52, 3);
     }
 
-    //We want to round the aperture to the nearest 1/3 stop
-    float aperture = outputValue;
-    //Convert aperture to f-stop
-    float fStop = 2.0 * log2(aperture);
-    float roundedFStop = round(fStop * 3.0) / 3.0;
-    float roundedAperture = pow(2.0, roundedFStop / 2.0);
-    float iso = 100 * pow(2, settings.isoIndex);
-    int32_t nd = pow(2, settings.ndFilterIndex);  
-
-    if (outputValue < 0.5) {
-        _display->setFont(ArialMT_Plain_24);
-        _display->drawString(0, 0, "-low-");
-    } else if (outputValue > 32) {
-        _display->setFont(ArialMT_Plain_24);
-        _display->drawString(0, 0, "-high-");
+    const stopSeries_t &apertures = stopSeries(STOP_QUANTITY_APERTURE, _view.increment);
+    char ndLabel[OLED_LABEL_SIZE];
+
+    snprintf(ndLabel, sizeof(ndLabel), "ND%u", (unsigned int)exposureNdFactor(_view.ndFilterIndex));
+
+    if (!renderOutOfRange(_view.output, apertures.minIndex, apertures.maxIndex)) {
+        char apertureLabel[OLED_LABEL_SIZE];
+        snprintf(apertureLabel, sizeof(apertureLabel), "f/%s", stopLabel(STOP_QUANTITY_APERTURE, _view.output));
+        drawText(0, 0, ArialMT_Plain_24, apertureLabel);
+    }
+
+    drawText(76, 0, Lato_Bold_8, "ISO");
+    drawText(76, 9, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_ISO, _view.isoIndex));
+
+    drawText(76, 22, Lato_Bold_8, "Shutter");
+    drawText(76, 31, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_SHUTTER, _view.shutterIndex));
+
+    drawText(76, 44, Lato_Bold_8, "ND Filter");
+    drawText(76, 53, ArialMT_Plain_10, (_view.ndFilterIndex > 0) ? ndLabel : "None");
+
+    drawText(4, 38, Lato_Bold_8, TYPE_TABLE[_view.type]);
+}
+
+void OledDisplay::renderPageShutter() {
+    _display->clear();
+
+    renderWidgetEv();
+
+    if (_view.adjustSetting == ADJUST_SETTING_ISO) {
+        _display->drawCircle(68, 10, 3);
+    } else if (_view.adjustSetting == ADJUST_SETTING_APERTURE)  {
+        _display->drawCircle(68, 31, 3);
     } else {
-        _display->setFont(ArialMT_Plain_24);
-        _display->drawString(0, 0, "f/" + String(roundedAperture, 1));
+        _display->drawCircle(68, 52, 3);
     }
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 0, "ISO");
-    _display->setFont(ArialMT_Plain_10);
-    _display->drawString(76, 9, String(iso, 0));
+    const stopSeries_t &shutters = stopSeries(STOP_QUANTITY_SHUTTER, _view.increment);
+    if (!renderOutOfRange(_view.output, shutters.minIndex, shutters.maxIndex)) {
+        drawText(0, 0, ArialMT_Plain_24, stopLabel(STOP_QUANTITY_SHUTTER, _view.output));
+    }
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 22, "Shutter");
-    _display->setFont(ArialMT_Plain_10);
-    _display->drawString(76, 31, SHUTTER_TABLE[settings.shutterIndex + SHUTTER_TABLE_OFFSET]);
+    char ndLabel[OLED_LABEL_SIZE];
+    snprintf(ndLabel, sizeof(ndLabel), "ND%u", (unsigned int)exposureNdFactor(_view.ndFilterIndex));
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 44, "ND Filter");
-    _display->setFont(ArialMT_Plain_10);
-    if (settings.ndFilterIndex > 0) {
-        _display->drawString(76, 53, "ND" + String(nd));
+    drawText(76, 0, Lato_Bold_8, "ISO");
+    drawText(76, 9, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_ISO, _view.isoIndex));
+
+    drawText(76, 22, Lato_Bold_8, "Aperture");
+    drawText(76, 31, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_APERTURE, _view.apertureIndex));
+
+    drawText(76, 44, Lato_Bold_8, "ND Filter");
+    drawText(76, 53, ArialMT_Plain_10, (_view.ndFilterIndex > 0) ? ndLabel : "None");
+
+    drawText(4, 38, Lato_Bold_8, TYPE_TABLE[_view.type]);
+}
+
+// Solved index outside what the camera can be set to, true when drawn
+bool OledDisplay::renderOutOfRange(int16_t index, int16_t min, int16_t max) {
+    if (index < min) {
+        drawText(0, 0, ArialMT_Plain_24, "-low-");
+    } else if (index > max) {
+        drawText(0, 0, ArialMT_Plain_24, "-high-");
     } else {
-        _display->drawString(76, 53, "None");
+        return false;
     }
+    return true;
+}
 
-    _display->setFont(Lato_Bold_8);
-    if (settings.type == LIGHT_METER_TYPE_INCIDENT) {
-        _display->drawString(4, 38, "Incident");
+void OledDisplay::renderPageIso() {
+    _display->clear();
+
+    renderWidgetEv();
+
+    if (_view.adjustSetting == ADJUST_SETTING_SHUTTER) {
+        _display->drawCircle(68, 10, 3);
+    } else if (_view.adjustSetting == ADJUST_SETTING_APERTURE)  {
+        _display->drawCircle(68, 31, 3);
     } else {
-        _display->drawString(4, 38, "Reflected");
+        _display->drawCircle(68, 52, 3);
+    }
+
+    const stopSeries_t &isos = stopSeries(STOP_QUANTITY_ISO, _view.increment);
+    if (!renderOutOfRange(_view.output, isos.minIndex, isos.maxIndex)) {
+        // Five digits don't fit left of the settings column, the last three become "K"
+        const char *label = stopLabel(STOP_QUANTITY_ISO, _view.output);
+        const int length = strlen(label);
+        char isoLabel[OLED_LABEL_SIZE];
+
+        if (length <= 4) {
+            snprintf(isoLabel, sizeof(isoLabel), "%s", label);
+        } else {
+            snprintf(isoLabel, sizeof(isoLabel), "%.*sK", length - 3, label);
+        }
+        drawText(0, 0, ArialMT_Plain_24, isoLabel);
+        drawText(4, 28, Lato_Bold_8, "ISO");
     }
 
-     
-    _display->display();
+    char ndLabel[OLED_LABEL_SIZE];
+    snprintf(ndLabel, sizeof(ndLabel), "ND%u", (unsigned int)exposureNdFactor(_view.ndFilterIndex));
+
+    drawText(76, 0, Lato_Bold_8, "Shutter");
+    drawText(76, 9, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_SHUTTER, _view.shutterIndex));
+
+    drawText(76, 22, Lato_Bold_8, "Aperture");
+    drawText(76, 31, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_APERTURE, _view.apertureIndex));
+
+    drawText(76, 44, Lato_Bold_8, "ND Filter");
+    drawText(76, 53, ArialMT_Plain_10, (_view.ndFilterIndex > 0) ? ndLabel : "None");
+
+    drawText(4, 38, Lato_Bold_8, TYPE_TABLE[_view.type]);
 }
 
-void OledDisplay::renderPageShutter() {
+void OledDisplay::renderPageNd() {
     _display->clear();
 
     renderWidgetEv();
 
-    if (settings.adjustSetting == ADJUST_SETTING_ISO) {
+    if (_view.adjustSetting == ADJUST_SETTING_ISO) {
         _display->drawCircle(68, 10, 3);
-    } else if (settings.adjustSetting == ADJUST_SETTING_APERTURE)  {
+    } else if (_view.adjustSetting == ADJUST_SETTING_APERTURE)  {
         _display->drawCircle(68, 31, 3);
     } else {
         _display->drawCircle(68, 52, 3);
     }
 
-    // Convert computed shutter seconds (outputValue) to nearest standard label
-    float shutterSeconds = outputValue;
+    if (!renderOutOfRange(_view.output, ND_FILTER_INDEX_MIN, ND_FILTER_INDEX_MAX)) {
+        char factorLabel[OLED_LABEL_SIZE];
 
-    if (shutterSeconds <= 0.0f) {
-        _display->setFont(ArialMT_Plain_24);
-        _display->drawString(0, 0, "-high-");
+        snprintf(factorLabel, sizeof(factorLabel), "%u", (unsigned int)exposureNdFactor(_view.output));
+        drawText(0, 0, ArialMT_Plain_24, (_view.output > 0) ? factorLabel : "None");
+        drawText(4, 28, Lato_Bold_8, "ND");
+    }
+
+    drawText(76, 0, Lato_Bold_8, "ISO");
+    drawText(76, 9, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_ISO, _view.isoIndex));
+
+    drawText(76, 22, Lato_Bold_8, "Aperture");
+    drawText(76, 31, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_APERTURE, _view.apertureIndex));
+
+    drawText(76, 44, Lato_Bold_8, "Shutter");
+    drawText(76, 53, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_SHUTTER, _view.shutterIndex));
+
+    drawText(4, 38, Lato_Bold_8, TYPE_TABLE[_view.type]);
+}
+
+void OledDisplay::renderPageFlicker() {
+    char frequencyLabel[OLED_LABEL_SIZE];
+    char depthLabel[OLED_LABEL_SIZE];
+    char shutterDepthLabel[OLED_LABEL_SIZE];
+    char indexLabel[OLED_LABEL_SIZE + 6] = "Index ";
+
+    _display->clear();
+
+    renderWidgetEv();
+
+    // Shutter is the only setting here, it decides what the camera sees
+    _display->drawCircle(68, 31, 3);
+
+    if (_view.flickerFrequencyTenths > 0) {
+        formatTenths(frequencyLabel, sizeof(frequencyLabel) - 2, _view.flickerFrequencyTenths);
+        strcat(frequencyLabel, "Hz");
+        drawText(0, 0, ArialMT_Plain_24, frequencyLabel);
     } else {
-        float shutterIndexF = -log2(shutterSeconds);
-        int shutterIndexRounded = (int)round(shutterIndexF);
+        drawText(0, 0, ArialMT_Plain_24, "Steady");
+    }
+
+    snprintf(depthLabel, sizeof(depthLabel), "%u%%", (unsigned int)_view.flickerDepthPercent);
+    snprintf(shutterDepthLabel, sizeof(shutterDepthLabel), "%u%%", (unsigned int)_view.flickerAtShutterPercent);
+    // Flicker index with two decimals, 0.00 to 1.00
+    const unsigned int indexHundredths = _view.flickerIndexHundredths;
+    snprintf(indexLabel + 6, sizeof(indexLabel) - 6, "%u.%02u", indexHundredths / 100, indexHundredths % 100);
+
+    drawText(76, 0, Lato_Bold_8, "Depth");
+    drawText(76, 9, ArialMT_Plain_10, depthLabel);
+
+    drawText(76, 22, Lato_Bold_8, "Shutter");
+    drawText(76, 31, ArialMT_Plain_10, stopLabel(STOP_QUANTITY_SHUTTER, _view.shutterIndex));
+
+    drawText(76, 44, Lato_Bold_8, "At shutter");
+    drawText(76, 53, ArialMT_Plain_10, shutterDepthLabel);
+
+    drawText(4, 38, Lato_Bold_8, indexLabel);
+}
 
-        if (shutterIndexRounded < SHUTTER_INDEX_MIN) {
-            shutterIndexRounded = SHUTTER_INDEX_MIN;
-        } else if (shutterIndexRounded > SHUTTER_INDEX_MAX) {
-            shutterIndexRounded = SHUTTER_INDEX_MAX;
+/*
+  2 x 2 grid, the aperture every camera needs on top and its ISO, shutter
+  and ND below. The active preset is marked with a circle
+*/
+void OledDisplay::renderPagePresets() {
+    const cameraPresets_t &presets = _view.presets;
+    const stopSeries_t &apertures = stopSeries(STOP_QUANTITY_APERTURE, presets.increment);
+
+    _display->clear();
+
+    for (uint8_t i = 0; i < CAMERA_PRESET_COUNT; i++) {
+        const int16_t x = (i % 2) * 64;
+        const int16_t y = (i / 2) * 32;
+        const int16_t output = _view.presetOutput[i];
+        char apertureLabel[OLED_LABEL_SIZE];
+        char settingsLabel[OLED_LABEL_SIZE * 2];
+
+        if (i == _view.activePreset) {
+            _display->drawCircle(x + 58, y + 8, 3);
         }
 
-        uint8_t tableIndex = shutterIndexRounded + SHUTTER_TABLE_OFFSET;
+        if (!(presets.usedMask & (1 << i))) {
+            drawText(x + 2, y, ArialMT_Plain_16, "--");
+            continue;
+        }
 
-        _display->setFont(ArialMT_Plain_24);
-        _display->drawString(0, 0, SHUTTER_TABLE[tableIndex]);
+        if (output < apertures.minIndex) {
+            drawText(x + 2, y, ArialMT_Plain_16, "-low-");
+        } else if (output > apertures.maxIndex) {
+            drawText(x + 2, y, ArialMT_Plain_16, "-high-");
+        } else {
+            snprintf(apertureLabel, sizeof(apertureLabel), "f/%s", stopEntry(STOP_QUANTITY_APERTURE, presets.increment, output).label);
+            drawText(x + 2, y, ArialMT_Plain_16, apertureLabel);
+        }
+
+        const int length = snprintf(settingsLabel, sizeof(settingsLabel), "%s %s",
+                                    stopEntry(STOP_QUANTITY_ISO, presets.increment, presets.isoIndex[i]).label,
+                                    stopEntry(STOP_QUANTITY_SHUTTER, presets.increment, presets.shutterIndex[i]).label);
+        if (presets.ndFilterIndex[i] > 0) {
+            snprintf(settingsLabel + length, sizeof(settingsLabel) - length, " ND%u",
+                     (unsigned int)exposureNdFactor(presets.ndFilterIndex[i]));
+        }
+        drawText(x + 2, y + 19, Lato_Bold_8, settingsLabel);
     }
+}
 
-    float iso = 100 * pow(2, settings.isoIndex);
-    int32_t nd = pow(2, settings.ndFilterIndex);  
+// Stops x100 to tenths, rounded half away from zero
+static int32_t hundredthsToTenths(int32_t hundredths) {
+    return (hundredths + ((hundredths < 0) ? -5 : 5)) / 10;
+}
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 0, "ISO");
-    _display->setFont(ArialMT_Plain_10);
-    _display->drawString(76, 9, String(iso, 0));
+/*
+  Reading under the cursor with its position, mean, spread and the
+  key:fill ratio of the two marked readings on the right
+*/
+void OledDisplay::renderPageMemory() {
+    char evLabel[OLED_LABEL_SIZE];
+    char positionLabel[OLED_LABEL_SIZE * 2];
+    char rangeLabel[OLED_LABEL_SIZE * 3];
+    char meanLabel[OLED_LABEL_SIZE];
+    char spreadLabel[OLED_LABEL_SIZE];
+    char ratioLabel[OLED_LABEL_SIZE];
+    char minLabel[OLED_LABEL_SIZE];
+    char maxLabel[OLED_LABEL_SIZE];
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 22, "Aperture");
-    _display->setFont(ArialMT_Plain_10);
-    _display->drawString(76, 31, APERTURE_TABLE[settings.apertureIndex + APERTURE_TABLE_OFFSET]);
+    _display->clear();
 
-    _display->setFont(Lato_Bold_8);
-    _display->drawString(76, 44, "ND Filter");
-    _display->setFont(ArialMT_Plain_10);
-    if (settings.ndFilterIndex > 0) {
-        _display->drawString(76, 53, "ND" + String(nd));
+    if (_view.memoryCount == 0) {
+        drawText(0, 0, ArialMT_Plain_24, "--");
+        return;
+    }
+
+    formatTenths(evLabel, sizeof(evLabel), hundredthsToTenths(_view.memoryEv));
+    drawText(0, 0, ArialMT_Plain_24, evLabel);
+
+    snprintf(positionLabel, sizeof(positionLabel), "EV %u/%u%s", _view.memoryCursor + 1, _view.memoryCount,
+             _view.memoryKey ? " Key" : (_view.memoryFill ? " Fill" : ""));
+    drawText(4, 28, Lato_Bold_8, positionLabel);
+
+    formatTenths(minLabel, sizeof(minLabel), hundredthsToTenths(_view.memoryMin));
+    formatTenths(maxLabel, sizeof(maxLabel), hundredthsToTenths(_view.memoryMax));
+    snprintf(rangeLabel, sizeof(rangeLabel), "Min %s Max %s", minLabel, maxLabel);
+    drawText(4, 38, Lato_Bold_8, rangeLabel);
+
+    formatTenths(meanLabel, sizeof(meanLabel), hundredthsToTenths(_view.memoryMean));
+    formatTenths(spreadLabel, sizeof(spreadLabel), hundredthsToTenths(_view.memoryMax - _view.memoryMin));
+
+    drawText(76, 0, Lato_Bold_8, "Mean");
+    drawText(76, 9, ArialMT_Plain_10, meanLabel);
+
+    drawText(76, 22, Lato_Bold_8, "Spread");
+    drawText(76, 31, ArialMT_Plain_10, spreadLabel);
+
+    drawText(76, 44, Lato_Bold_8, "Key:Fill");
+    if (_view.memoryHasRatio) {
+        // 2^stops, the brighter side is written first
+        const int16_t stops = abs(_view.memoryRatio);
+        char factorLabel[OLED_LABEL_SIZE];
+
+        formatTenths(factorLabel, sizeof(factorLabel), lroundf(exp2f(stops / 100.0f) * 10));
+        snprintf(ratioLabel, sizeof(ratioLabel), (_view.memoryRatio >= 0) ? "%s:1" : "1:%s", factorLabel);
+        drawText(76, 53, ArialMT_Plain_10, ratioLabel);
     } else {
-        _display->drawString(76, 53, "None");
+        drawText(76, 53, ArialMT_Plain_10, "--");
     }
+}
 
-    _display->setFont(Lato_Bold_8);
-    if (settings.type == LIGHT_METER_TYPE_INCIDENT) {
-        _display->drawString(4, 38, "Incident");
+// Cycle counts in at most 4 characters: "812", "9.5k", "950k", "6.1M", "61M"
+static void formatCycles(char *buffer, size_t size, uint32_t cycles) {
+    if (cycles < 1000) {
+        snprintf(buffer, size, "%lu", (unsigned long)cycles);
+    } else if (cycles < 10000) {
+        snprintf(buffer, size, "%lu.%luk", (unsigned long)(cycles / 1000), (unsigned long)(cycles / 100 % 10));
+    } else if (cycles < 1000000) {
+        snprintf(buffer, size, "%luk", (unsigned long)(cycles / 1000));
+    } else if (cycles < 10000000) {
+        snprintf(buffer, size, "%lu.%luM", (unsigned long)(cycles / 1000000), (unsigned long)(cycles / 100000 % 10));
     } else {
-        _display->drawString(4, 38, "Reflected");
+        snprintf(buffer, size, "%luM", (unsigned long)(cycles / 1000000));
+    }
+}
+
+void OledDisplay::renderDiagnosticsRow(int16_t y, const char *name, uint8_t stage) {
+    timingSummary_t stats;
+    char label[OLED_LABEL_SIZE];
+
+    stageTiming.summary(stage, &stats);
+    const uint32_t values[] = {stats.min, stats.p50, stats.p99, stats.max};
+
+    _display->drawString(DIAGNOSTICS_COLUMNS[0], y, name);
+    for (uint8_t i = 0; i < 4; i++) {
+        formatCycles(label, sizeof(label), values[i]);
+        _display->drawString(DIAGNOSTICS_COLUMNS[i + 1], y, label);
     }
-     
-    _display->display();
-}
\ No newline at end of file
+}
+
+/*
+  Stage timing in CPU cycles. Only the page of the current mode gets a
+  render row, the Serial "s" command prints every stage
+*/
+void OledDisplay::renderPageDiagnostics() {
+    const uint8_t renderStage = TIMING_STAGE_RENDER_APERTURE + _measurement.settings.mode;
+
+    _display->clear();
+    _display->setFont(Lato_Bold_8);
+
+    _display->drawString(DIAGNOSTICS_COLUMNS[0], 0, "Cycles");
+    _display->drawString(DIAGNOSTICS_COLUMNS[1], 0, "min");
+    _display->drawString(DIAGNOSTICS_COLUMNS[2], 0, "p50");
+    _display->drawString(DIAGNOSTICS_COLUMNS[3], 0, "p99");
+    _display->drawString(DIAGNOSTICS_COLUMNS[4], 0, "max");
+    _display->drawHorizontalLine(0, 11, OLED_WIDTH);
+
+    renderDiagnosticsRow(13, "Read", TIMING_STAGE_SENSOR_READ);
+    renderDiagnosticsRow(23, "EV", TIMING_STAGE_EV_COMPUTE);
+    renderDiagnosticsRow(33, "Draw", renderStage);
+    renderDiagnosticsRow(43, "Flush", TIMING_STAGE_DISPLAY_FLUSH);
+    renderDiagnosticsRow(53, "Save", TIMING_STAGE_SETTINGS_WRITE);
+}
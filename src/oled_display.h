@@ -3,41 +3,129 @@
 
 #include "SSD1306.h"
 #include "types.h"
+#include "oled_flush.h"
+#include "measurement.h"
+#include "glyph_atlas.h"
+#include "camera_presets.h"
+#include "measurement_memory.h"
 
 #define OLED_COL_COUNT 64
 #define OLED_DISPLAY_PAGE_COUNT 1
 
-extern float lux;
-extern float ev;
-extern float evIso;
-extern float reflectedEv;
-extern float incidentEv;
+// Stack buffer size for formatted labels, longest is "102400"
+#define OLED_LABEL_SIZE 12
+
+// Full is what the ThingPulse init() sets
+#define OLED_CONTRAST_FULL 0xCF
+#define OLED_CONTRAST_DIM 0x08
 
 extern settings_t settings;
-extern float outputValue;
+extern CameraPresets cameraPresets;
+extern MeasurementMemory measurementMemory;
 
-extern String ISO_TABLE[];
-extern String APERTURE_TABLE[];
-extern String SHUTTER_TABLE[];
-extern String TYPE_TABLE[];
+// Everything a page draws, already rounded the way it ends up on screen
+typedef struct oledView_s {
+    uint8_t page;
+    uint8_t adjustSetting;
+    uint8_t type;
+    uint8_t evWide;
+    // stopIncrement_e the indexes below are counted in
+    uint8_t increment;
+    int8_t isoIndex;
+    int8_t apertureIndex;
+    int8_t shutterIndex;
+    int8_t ndFilterIndex;
+    int16_t evTenths;
+    /*
+      Exposure pages: the solved index, ND rounded to full stops, one past
+      either end when out of range
+    */
+    int16_t output;
+    uint16_t flickerFrequencyTenths;
+    uint16_t flickerDepthPercent;
+    uint16_t flickerAtShutterPercent;
+    uint16_t flickerIndexHundredths;
+    // Presets page, outputs of stored presets only
+    cameraPresets_t presets;
+    int16_t presetOutput[CAMERA_PRESET_COUNT];
+    uint8_t activePreset;
+    // Memory page, EV values x100 as stored
+    uint8_t memoryCount;
+    uint8_t memoryCursor;
+    uint8_t memoryKey;
+    uint8_t memoryFill;
+    uint8_t memoryHasRatio;
+    int16_t memoryEv;
+    int16_t memoryMean;
+    int16_t memoryMin;
+    int16_t memoryMax;
+    int16_t memoryRatio;
+} oledView_t;
 
 class OledDisplay {
     public:
-        OledDisplay(SSD1306 *display);
+        OledDisplay(SSD1306 *display, TwoWire *wire, uint8_t address);
         void init();
         void loop();
         void setPage(uint8_t page);
+        uint8_t getPage() { return _page; }
         void forceDisplay();
         void setOnlyForcedDisplay(bool onlyForcedDisplay);
+        void setContrast(uint8_t contrast);
+        // Nothing is rendered while the panel is off, it redraws once turned on
+        void setPanelOn(bool on);
+        bool isPanelOn() { return _panelOn; }
+        uint16_t getLastFrameBytes();
+        uint32_t getTotalFlushBytes();
+        // Frames drawn and frames skipped because nothing visible changed
+        uint32_t getRenderedFrames() { return _renderedFrames; }
+        uint32_t getSkippedFrames() { return _skippedFrames; }
+        uint16_t getAtlasBytes() { return _atlas.getUsedBytes(); }
+        uint8_t getAtlasGlyphs() { return _atlas.getGlyphCount(); }
     private:
+        // Times the render functions on their own
+        friend class Benchmark;
         SSD1306 *_display;
+        OledFlush _flush;
+        void flush();
         void renderPageAperture();
         void renderPageShutter();
+        void renderPageIso();
+        void renderPageNd();
+        bool renderOutOfRange(int16_t index, int16_t min, int16_t max);
+        const char *stopLabel(uint8_t quantity, int16_t index) {
+            return stopEntry(quantity, _view.increment, index).label;
+        }
+        void renderPageFlicker();
+        void renderPagePresets();
+        void renderPageMemory();
+        void renderPageDiagnostics();
+        void renderDiagnosticsRow(int16_t y, const char *name, uint8_t stage);
         void renderWidgetEv();
         void page();
+        // Through the glyph atlas when it has the text, the font renderer otherwise
+        template <class F> void drawText(int16_t x, int16_t y, const F *font, const char *text) {
+            if (!_atlas.drawString(_display->buffer, x, y, (const uint8_t *)font, text)) {
+                _display->setFont(font);
+                _display->drawString(x, y, text);
+            }
+        }
+        void buildView(oledView_t *view);
+        int16_t outputIndex(uint8_t quantity, uint8_t increment);
+        static uint32_t hashView(const oledView_t &view);
         uint8_t _page = OLED_PAGE_NONE;
-        bool _forceDisplay = false;
+        // Frame being drawn, consistent tuple of sample, output and settings
+        measurement_t _measurement;
+        oledView_t _view;
+        GlyphAtlas _atlas;
+        uint32_t _viewHash = 0;
+        bool _viewHashValid = false;
+        uint32_t _renderedFrames = 0;
+        uint32_t _skippedFrames = 0;
+        // Set from the sensor task on the other core
+        std::atomic<bool> _forceDisplay{false};
         bool _onlyForcedDisplay = false;
+        bool _panelOn = true;
 };
 
 
@@ -0,0 +1,112 @@
+#include "oled_flush.h"
+#include "i2c_arbiter.h"
+
+#define SSD1306_CONTROL_COMMAND 0x00
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+OledFlush::OledFlush(TwoWire *wire, uint8_t address) {
+    _wire = wire;
+    _address = address;
+}
+
+// Next flush sends the whole frame, use after anything else wrote the panel
+void OledFlush::invalidate() {
+    _shadowValid = false;
+}
+
+void OledFlush::command(const uint8_t *commands, uint8_t count) {
+    i2cArbiter.acquire(I2C_CLIENT_DISPLAY);
+    _wire->beginTransmission(_address);
+    _wire->write(SSD1306_CONTROL_COMMAND);
+    _wire->write(commands, count);
+    _wire->endTransmission();
+    i2cArbiter.release(I2C_CLIENT_DISPLAY, 2 + count);
+}
+
+uint16_t OledFlush::sendRange(const uint8_t *buffer, uint8_t page, uint8_t columnStart, uint8_t columnEnd) {
+    uint16_t bytes = 0;
+
+    // Every transaction is arbitrated on its own, a sensor access can go in between
+    i2cArbiter.acquire(I2C_CLIENT_DISPLAY);
+    _wire->beginTransmission(_address);
+    _wire->write(SSD1306_CONTROL_COMMAND);
+    _wire->write(SSD1306_COLUMNADDR);
+    _wire->write(columnStart);
+    _wire->write(columnEnd);
+    _wire->write(SSD1306_PAGEADDR);
+    _wire->write(page);
+    _wire->write(page);
+    _wire->endTransmission();
+    i2cArbiter.release(I2C_CLIENT_DISPLAY, 8);
+    bytes += 8;
+
+    const uint8_t *data = buffer + page * OLED_WIDTH;
+    uint8_t column = columnStart;
+
+    while (column <= columnEnd) {
+        uint8_t length = columnEnd - column + 1;
+        if (length > OLED_FLUSH_CHUNK_SIZE) {
+            length = OLED_FLUSH_CHUNK_SIZE;
+        }
+
+        i2cArbiter.acquire(I2C_CLIENT_DISPLAY);
+        _wire->beginTransmission(_address);
+        _wire->write(SSD1306_CONTROL_DATA);
+        _wire->write(data + column, length);
+        _wire->endTransmission();
+        i2cArbiter.release(I2C_CLIENT_DISPLAY, 2 + length);
+        bytes += 2 + length;
+
+        column += length;
+    }
+
+    memcpy(_shadow + page * OLED_WIDTH + columnStart, data + columnStart, columnEnd - columnStart + 1);
+
+    return bytes;
+}
+
+uint16_t OledFlush::flush(const uint8_t *buffer) {
+    uint16_t bytes = 0;
+
+    if (!_shadowValid) {
+        for (uint8_t page = 0; page < OLED_PAGE_ROW_COUNT; page++) {
+            bytes += sendRange(buffer, page, 0, OLED_WIDTH - 1);
+        }
+        _shadowValid = true;
+    } else {
+        for (uint8_t page = 0; page < OLED_PAGE_ROW_COUNT; page++) {
+            const uint8_t *current = buffer + page * OLED_WIDTH;
+            const uint8_t *previous = _shadow + page * OLED_WIDTH;
+            int16_t rangeStart = -1;
+            int16_t lastChanged = -1;
+
+            for (int16_t column = 0; column < OLED_WIDTH; column++) {
+                if (current[column] == previous[column]) {
+                    continue;
+                }
+
+                if (rangeStart >= 0 && column - lastChanged > OLED_FLUSH_MIN_GAP) {
+                    bytes += sendRange(buffer, page, rangeStart, lastChanged);
+                    rangeStart = -1;
+                }
+
+                if (rangeStart < 0) {
+                    rangeStart = column;
+                }
+                lastChanged = column;
+            }
+
+            if (rangeStart >= 0) {
+                bytes += sendRange(buffer, page, rangeStart, lastChanged);
+            }
+        }
+    }
+
+    _lastFrameBytes = bytes;
+    _totalBytes += bytes;
+    _frameCount++;
+
+    return bytes;
+}
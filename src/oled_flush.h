@@ -0,0 +1,48 @@
+#ifndef OLED_FLUSH_H
+#define OLED_FLUSH_H
+
+#include "Arduino.h"
+#include <Wire.h>
+
+#define OLED_WIDTH 128
+#define OLED_HEIGHT 64
+#define OLED_PAGE_ROWS 8
+#define OLED_PAGE_ROW_COUNT (OLED_HEIGHT / OLED_PAGE_ROWS)
+#define OLED_BUFFER_SIZE (OLED_WIDTH * OLED_PAGE_ROW_COUNT)
+
+// Data bytes per I2C transaction, same as the ThingPulse driver, and the most a sensor read waits for
+#define OLED_FLUSH_CHUNK_SIZE 16
+
+/*
+  Unchanged columns inside a page row are still sent when the gap is shorter
+  than this, a new address window costs about as much on the bus
+*/
+#define OLED_FLUSH_MIN_GAP 10
+
+/*
+  Differential SSD1306 flush. Keeps a shadow of what the panel shows and
+  transmits only changed column ranges of each 8 row page. Bus bytes include
+  the I2C address byte of every transaction
+*/
+class OledFlush {
+    public:
+        OledFlush(TwoWire *wire, uint8_t address);
+        uint16_t flush(const uint8_t *buffer);
+        void invalidate();
+        // Controller commands in one transaction, contrast and display on/off
+        void command(const uint8_t *commands, uint8_t count);
+        uint16_t getLastFrameBytes() { return _lastFrameBytes; }
+        uint32_t getTotalBytes() { return _totalBytes; }
+        uint32_t getFrameCount() { return _frameCount; }
+    private:
+        uint16_t sendRange(const uint8_t *buffer, uint8_t page, uint8_t columnStart, uint8_t columnEnd);
+        TwoWire *_wire;
+        uint8_t _address;
+        uint8_t _shadow[OLED_BUFFER_SIZE];
+        bool _shadowValid = false;
+        uint16_t _lastFrameBytes = 0;
+        uint32_t _totalBytes = 0;
+        uint32_t _frameCount = 0;
+};
+
+#endif
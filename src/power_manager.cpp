@@ -0,0 +1,196 @@
+#include "power_manager.h"
+#include "i2c_arbiter.h"
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+/*
+  Typical currents in uA from the ESP32, SSD1306 panel and VEML7700
+  datasheets, in powerLoad_e order. Good enough to compare builds, not a
+  replacement for measuring the board
+*/
+static const uint32_t POWER_LOAD_MICROAMPS[POWER_LOAD_COUNT] = {
+    50000,  // 240 MHz, both cores awake
+    25000,  // 80 MHz
+    800,    // light sleep
+    8000,   // panel at full contrast, meter pages light ~15% of the pixels
+    2500,   // panel at OLED_CONTRAST_DIM
+    10,     // panel sleep
+    45,     // continuous conversions
+    11      // power save mode 2
+};
+
+static const char *const POWER_LOAD_NAMES[POWER_LOAD_COUNT] = {
+    "cpu_active",
+    "cpu_idle",
+    "cpu_light_sleep",
+    "display_full",
+    "display_dim",
+    "display_off",
+    "sensor_continuous",
+    "sensor_power_save"
+};
+
+PowerManager::PowerManager(OledDisplay *display, const uint8_t *wakePins, uint8_t wakePinCount) {
+    _display = display;
+    _wakePins = wakePins;
+    _wakePinCount = wakePinCount;
+}
+
+void PowerManager::begin() {
+    setCpuFrequencyMhz(POWER_CPU_ACTIVE_MHZ);
+    _display->setContrast(OLED_CONTRAST_FULL);
+    _lastActivity = millis();
+    _accountedAt = _lastActivity;
+}
+
+// Time since the last call goes to the loads of the current state
+void PowerManager::account() {
+    portENTER_CRITICAL(&_mux);
+
+    const uint32_t now = millis();
+    const uint32_t elapsed = now - _accountedAt;
+    const powerState_e state = getState();
+
+    _accountedAt = now;
+    _elapsedMs += elapsed;
+
+    if (_sleeping) {
+        _loadMs[POWER_LOAD_CPU_LIGHT_SLEEP] += elapsed;
+    } else {
+        _loadMs[(state == POWER_STATE_OFF) ? POWER_LOAD_CPU_IDLE : POWER_LOAD_CPU_ACTIVE] += elapsed;
+    }
+    _loadMs[POWER_LOAD_DISPLAY_FULL + state] += elapsed;
+    _loadMs[_sensorPowerSave ? POWER_LOAD_SENSOR_POWER_SAVE : POWER_LOAD_SENSOR_CONTINUOUS] += elapsed;
+
+    portEXIT_CRITICAL(&_mux);
+}
+
+// Called on every sensor step, the time so far belongs to the previous sensor load
+void PowerManager::setSensorPowerSave(bool powerSave) {
+    if (powerSave == _sensorPowerSave) {
+        return;
+    }
+
+    account();
+    _sensorPowerSave = powerSave;
+}
+
+void PowerManager::setState(powerState_e state) {
+    const powerState_e previous = getState();
+
+    if (state == previous) {
+        return;
+    }
+
+    account();
+
+    if (state == POWER_STATE_OFF) {
+        _display->setPanelOn(false);
+        setCpuFrequencyMhz(POWER_CPU_IDLE_MHZ);
+    } else {
+        if (previous == POWER_STATE_OFF) {
+            setCpuFrequencyMhz(POWER_CPU_ACTIVE_MHZ);
+            _display->setPanelOn(true);
+        }
+        _display->setContrast((state == POWER_STATE_DIM) ? OLED_CONTRAST_DIM : OLED_CONTRAST_FULL);
+    }
+
+    _state = state;
+}
+
+bool PowerManager::activity() {
+    const bool wasOff = getState() == POWER_STATE_OFF;
+
+    _lastActivity = millis();
+    setState(POWER_STATE_ACTIVE);
+    return wasOff;
+}
+
+bool PowerManager::loop() {
+    const uint32_t inactive = millis() - _lastActivity;
+
+    if (getState() == POWER_STATE_ACTIVE && inactive >= POWER_DIM_MS) {
+        setState(POWER_STATE_DIM);
+    } else if (getState() == POWER_STATE_DIM && inactive >= POWER_OFF_MS) {
+        setState(POWER_STATE_OFF);
+        return true;
+    }
+    return false;
+}
+
+bool PowerManager::lightSleep() {
+    if (getState() != POWER_STATE_OFF || !_sensorPowerSave) {
+        return false;
+    }
+
+    if ((int32_t)(_nextSampleAt - millis()) < POWER_LIGHT_SLEEP_MIN_MS) {
+        return false;
+    }
+
+    // A sensor transaction in flight finishes first, the next one waits for the wakeup
+    i2cArbiter.acquire(I2C_CLIENT_DISPLAY);
+
+    // The UART stops while asleep, let pending output out first
+    Serial.flush();
+
+    // Waiting for the bus and the UART took some of the window
+    const int32_t window = (int32_t)(_nextSampleAt - millis());
+    if (window < POWER_LIGHT_SLEEP_MIN_MS) {
+        i2cArbiter.release(I2C_CLIENT_DISPLAY, 0);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _wakePinCount; i++) {
+        gpio_wakeup_enable((gpio_num_t)_wakePins[i], GPIO_INTR_LOW_LEVEL);
+    }
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)window * 1000);
+
+    account();
+    _sleeping = true;
+    esp_light_sleep_start();
+    account();
+    _sleeping = false;
+    _lightSleeps++;
+
+    // No bus bytes, the bus only sat idle
+    i2cArbiter.release(I2C_CLIENT_DISPLAY, 0);
+
+    // Wakeup takes over the interrupt type of the pin, the buttons need their edges back
+    for (uint8_t i = 0; i < _wakePinCount; i++) {
+        gpio_wakeup_disable((gpio_num_t)_wakePins[i]);
+        gpio_set_intr_type((gpio_num_t)_wakePins[i], GPIO_INTR_ANYEDGE);
+    }
+    return true;
+}
+
+void PowerManager::getEnergy(powerEnergy_t *energy) {
+    uint64_t microampMs = 0;
+
+    account();
+
+    energy->elapsedMs = _elapsedMs;
+    for (uint8_t load = 0; load < POWER_LOAD_COUNT; load++) {
+        energy->dutyPerMille[load] = (_elapsedMs > 0) ? (uint64_t)_loadMs[load] * 1000 / _elapsedMs : 0;
+        microampMs += (uint64_t)_loadMs[load] * POWER_LOAD_MICROAMPS[load];
+    }
+    energy->averageMicroamps = (_elapsedMs > 0) ? microampMs / _elapsedMs : 0;
+    energy->batteryHours = (energy->averageMicroamps > 0) ? (uint64_t)POWER_BATTERY_MAH * 1000 / energy->averageMicroamps : 0;
+}
+
+void PowerManager::print() {
+    char line[128];
+    powerEnergy_t energy;
+
+    getEnergy(&energy);
+
+    for (uint8_t load = 0; load < POWER_LOAD_COUNT; load++) {
+        snprintf(line, sizeof(line), "power load=%s duty_per_mille=%u current_ua=%lu\n", POWER_LOAD_NAMES[load],
+                 energy.dutyPerMille[load], (unsigned long)POWER_LOAD_MICROAMPS[load]);
+        Serial.print(line);
+    }
+    snprintf(line, sizeof(line), "power elapsed_ms=%lu average_ua=%lu battery_hours=%lu light_sleeps=%lu\n",
+             (unsigned long)energy.elapsedMs, (unsigned long)energy.averageMicroamps,
+             (unsigned long)energy.batteryHours, (unsigned long)_lightSleeps);
+    Serial.print(line);
+}
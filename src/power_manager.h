@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "Arduino.h"
+#include <atomic>
+#include "oled_display.h"
+
+// Without a button press the display dims, then turns off
+#define POWER_DIM_MS 20000
+#define POWER_OFF_MS 60000
+
+/*
+  80 MHz and up keep the APB clock at 80 MHz, so I2C and UART timing is
+  the same at both
+*/
+#define POWER_CPU_ACTIVE_MHZ 240
+#define POWER_CPU_IDLE_MHZ 80
+
+// Shorter gaps cost more in wakeup latency than light sleep saves
+#define POWER_LIGHT_SLEEP_MIN_MS 20
+
+// Only scales the battery life estimate
+#define POWER_BATTERY_MAH 1000
+
+enum powerState_e {
+    POWER_STATE_ACTIVE = 0,
+    POWER_STATE_DIM,
+    // Display off, CPU clocked down, light sleep between sensor samples
+    POWER_STATE_OFF,
+    POWER_STATE_COUNT
+};
+
+/*
+  Energy model loads. CPU, display and sensor are each in exactly one of
+  their loads at any time, so the duty cycles of one part add up to 1000
+*/
+enum powerLoad_e {
+    POWER_LOAD_CPU_ACTIVE = 0,
+    POWER_LOAD_CPU_IDLE,
+    POWER_LOAD_CPU_LIGHT_SLEEP,
+    POWER_LOAD_DISPLAY_FULL,
+    POWER_LOAD_DISPLAY_DIM,
+    POWER_LOAD_DISPLAY_OFF,
+    POWER_LOAD_SENSOR_CONTINUOUS,
+    POWER_LOAD_SENSOR_POWER_SAVE,
+    POWER_LOAD_COUNT
+};
+
+typedef struct powerEnergy_s {
+    uint32_t elapsedMs;
+    // Per mille of the elapsed time
+    uint16_t dutyPerMille[POWER_LOAD_COUNT];
+    uint32_t averageMicroamps;
+    uint32_t batteryHours;
+} powerEnergy_t;
+
+/*
+  Owned by the UI loop. Button activity keeps the meter in the active
+  state, inactivity dims the display and then turns it off together with
+  the CPU clock. The sensor task follows the state on its own and reports
+  back when the VEML7700 is in power save and when it samples next, light
+  sleep fills the time in between. Time spent in every load is accounted
+  on each state change, average current is the duty cycle weighted sum of
+  the typical load currents
+*/
+class PowerManager {
+    public:
+        PowerManager(OledDisplay *display, const uint8_t *wakePins, uint8_t wakePinCount);
+        void begin();
+        // Button event, true when it only woke the display up
+        bool activity();
+        // True when the display just turned off
+        bool loop();
+        powerState_e getState() { return (powerState_e)_state.load(); }
+        // Sensor task side
+        void setSensorPowerSave(bool powerSave);
+        void setNextSampleAt(uint32_t ms) { _nextSampleAt = ms; }
+        /*
+          Light sleep until the next sensor sample or a button, only with the
+          display off and the sensor in power save. Holds the I2C bus while
+          asleep so no sensor transaction is cut off. True when it slept
+        */
+        bool lightSleep();
+        uint32_t getLightSleeps() { return _lightSleeps; }
+        void getEnergy(powerEnergy_t *energy);
+        // One "power load=..." line per load and a summary line
+        void print();
+    private:
+        void setState(powerState_e state);
+        void account();
+        OledDisplay *_display;
+        const uint8_t *_wakePins;
+        uint8_t _wakePinCount;
+        std::atomic<uint8_t> _state{POWER_STATE_ACTIVE};
+        std::atomic<bool> _sensorPowerSave{false};
+        std::atomic<uint32_t> _nextSampleAt{0};
+        // account() runs on both cores, from the UI loop and the sensor task
+        portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+        bool _sleeping = false;
+        uint32_t _lastActivity = 0;
+        uint32_t _accountedAt = 0;
+        uint32_t _elapsedMs = 0;
+        uint32_t _loadMs[POWER_LOAD_COUNT] = {};
+        uint32_t _lightSleeps = 0;
+};
+
+#endif
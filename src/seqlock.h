@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+
+/*
+  Single writer sequence lock. The writer never blocks, readers retry while
+  a write is in progress, so a reader always gets a consistent copy of T
+  without a mutex. Meant for small POD structs shared between the cores
+*/
+template <class T> class SeqLock {
+    public:
+        void write(const T &value) {
+            const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+
+            // Odd sequence marks a write in progress
+            _sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            memcpy((void *)&_value, &value, sizeof(T));
+
+            _sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        // Returns the sequence number of the copy, it changes on every write
+        uint32_t read(T *value) const {
+            uint32_t before;
+            uint32_t after;
+
+            do {
+                before = _sequence.load(std::memory_order_acquire);
+                memcpy(value, (const void *)&_value, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = _sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) || before != after);
+
+            return before;
+        }
+
+        uint32_t getSequence() const {
+            return _sequence.load(std::memory_order_acquire);
+        }
+    private:
+        std::atomic<uint32_t> _sequence{0};
+        volatile T _value;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "settings_store.h"
+#include "crc16.h"
+#include "stage_timing.h"
+
+static_assert(sizeof(settingsRecord_t) == SETTINGS_RECORD_SIZE, "settings record must fill a journal slot");
+static_assert(sizeof(settings_t) <= SETTINGS_RECORD_PAYLOAD_SIZE, "settings_t does not fit a journal record");
+
+static uint16_t settingsRecordCrc(const settingsRecord_t &record) {
+    return crc16Ccitt((const uint8_t *)&record.sequence, SETTINGS_RECORD_SIZE - offsetof(settingsRecord_t, sequence));
+}
+
+bool SettingsStore::readRecord(uint32_t slot, settingsRecord_t *record) {
+    if (esp_partition_read(_partition, slot * SETTINGS_RECORD_SIZE, record, SETTINGS_RECORD_SIZE) != ESP_OK) {
+        return false;
+    }
+    return record->magic == SETTINGS_RECORD_MAGIC && record->crc == settingsRecordCrc(*record);
+}
+
+bool SettingsStore::isSlotBlank(uint32_t slot) {
+    uint32_t words[SETTINGS_RECORD_SIZE / 4];
+
+    if (esp_partition_read(_partition, slot * SETTINGS_RECORD_SIZE, words, SETTINGS_RECORD_SIZE) != ESP_OK) {
+        return false;
+    }
+    for (uint8_t i = 0; i < SETTINGS_RECORD_SIZE / 4; i++) {
+        if (words[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  Scans the journal for the newest valid record. Returns false when there is
+  none, settings are left untouched then
+*/
+bool SettingsStore::begin(settings_t *settings) {
+    settingsRecord_t record;
+    bool found = false;
+    uint32_t latestSlot = 0;
+
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, SETTINGS_STORE_PARTITION);
+    if (_partition == NULL) {
+        return false;
+    }
+
+    _slotCount = _partition->size / SETTINGS_RECORD_SIZE;
+
+    for (uint32_t slot = 0; slot < _slotCount; slot++) {
+        if (readRecord(slot, &record) && (!found || record.sequence > _sequence)) {
+            found = true;
+            latestSlot = slot;
+            _sequence = record.sequence;
+            memcpy(settings, record.payload, sizeof(settings_t));
+        }
+    }
+
+    _nextSlot = found ? (latestSlot + 1) % _slotCount : 0;
+    _stored = *settings;
+    _pending = *settings;
+
+    return found;
+}
+
+void SettingsStore::update(const settings_t &settings) {
+    _pending = settings;
+    _dirty = memcmp(&_pending, &_stored, sizeof(settings_t)) != 0;
+    _lastChange = millis();
+}
+
+void SettingsStore::loop() {
+    if (_dirty && millis() - _lastChange >= SETTINGS_STORE_QUIET_MS) {
+        flush();
+    }
+}
+
+// Writes pending changes right away, call before sleep or power off
+void SettingsStore::flush() {
+    if (!_dirty) {
+        return;
+    }
+
+    const uint32_t writeStart = StageTiming::start();
+    const bool written = append(_pending);
+    stageTiming.stop(TIMING_STAGE_SETTINGS_WRITE, writeStart);
+
+    if (written) {
+        _stored = _pending;
+        _dirty = false;
+    }
+}
+
+bool SettingsStore::append(const settings_t &settings) {
+    settingsRecord_t record;
+    const uint32_t slotsPerSector = SETTINGS_STORE_SECTOR_SIZE / SETTINGS_RECORD_SIZE;
+
+    if (_partition == NULL) {
+        return false;
+    }
+
+    // Skip slots left dirty by an interrupted write
+    for (uint32_t attempts = 0; attempts < _slotCount; attempts++) {
+        if (_nextSlot % slotsPerSector == 0) {
+            // Entering a sector, it holds old records from the previous round
+            const uint32_t offset = _nextSlot * SETTINGS_RECORD_SIZE;
+            if (esp_partition_erase_range(_partition, offset, SETTINGS_STORE_SECTOR_SIZE) != ESP_OK) {
+                return false;
+            }
+            _eraseCount++;
+            break;
+        }
+        if (isSlotBlank(_nextSlot)) {
+            break;
+        }
+        _nextSlot = (_nextSlot + 1) % _slotCount;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.magic = SETTINGS_RECORD_MAGIC;
+    record.reserved = 0xFF;
+    record.sequence = ++_sequence;
+    memcpy(record.payload, &settings, sizeof(settings_t));
+    record.crc = settingsRecordCrc(record);
+
+    if (esp_partition_write(_partition, _nextSlot * SETTINGS_RECORD_SIZE, &record, SETTINGS_RECORD_SIZE) != ESP_OK) {
+        return false;
+    }
+
+    _nextSlot = (_nextSlot + 1) % _slotCount;
+    _writeCount++;
+
+    return true;
+}
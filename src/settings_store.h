@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include "Arduino.h"
+#include "types.h"
+#include <esp_partition.h>
+
+#define SETTINGS_STORE_PARTITION "settings"
+#define SETTINGS_STORE_SECTOR_SIZE 4096
+
+#define SETTINGS_RECORD_MAGIC 0x5A
+#define SETTINGS_RECORD_SIZE 32
+#define SETTINGS_RECORD_PAYLOAD_SIZE (SETTINGS_RECORD_SIZE - 8)
+
+// Settings are written once they stopped changing for this long
+#define SETTINGS_STORE_QUIET_MS 3000
+
+typedef struct settingsRecord_s {
+    uint8_t magic;
+    uint8_t reserved;
+    uint16_t crc;
+    uint32_t sequence;
+    uint8_t payload[SETTINGS_RECORD_PAYLOAD_SIZE];
+} settingsRecord_t;
+
+/*
+  Write-behind settings journal. Changes are coalesced in RAM and appended
+  as CRC checked records to a raw flash partition, round-robin over its
+  sectors. A sector is only erased when the journal moves into it, so each
+  erase is spread over SETTINGS_STORE_SECTOR_SIZE / SETTINGS_RECORD_SIZE
+  writes and over all sectors of the partition
+*/
+class SettingsStore {
+    public:
+        bool begin(settings_t *settings);
+        void update(const settings_t &settings);
+        void loop();
+        void flush();
+        bool isDirty() { return _dirty; }
+        uint32_t getWriteCount() { return _writeCount; }
+        uint32_t getEraseCount() { return _eraseCount; }
+    private:
+        bool readRecord(uint32_t slot, settingsRecord_t *record);
+        bool isSlotBlank(uint32_t slot);
+        bool append(const settings_t &settings);
+        const esp_partition_t *_partition = NULL;
+        uint32_t _slotCount = 0;
+        uint32_t _nextSlot = 0;
+        uint32_t _sequence = 0;
+        settings_t _pending;
+        settings_t _stored;
+        bool _dirty = false;
+        uint32_t _lastChange = 0;
+        uint32_t _writeCount = 0;
+        uint32_t _eraseCount = 0;
+};
+
+#endif
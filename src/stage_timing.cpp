@@ -0,0 +1,95 @@
+#include "stage_timing.h"
+
+static const char *const STAGE_NAMES[TIMING_STAGE_COUNT] = {
+    "sensor_read",
+    "ev_compute",
+    "render_aperture",
+    "render_shutter",
+    "render_iso",
+    "render_nd",
+    "render_flicker",
+    "render_presets",
+    "render_memory",
+    "display_flush",
+    "settings_write"
+};
+
+static uint8_t timingBucket(uint32_t cycles) {
+    if (cycles < TIMING_SUB_BUCKETS) {
+        return cycles;
+    }
+
+    const uint8_t shift = 31 - __builtin_clz(cycles) - TIMING_SUB_BUCKET_BITS;
+    return ((shift + 1) << TIMING_SUB_BUCKET_BITS) + ((cycles >> shift) & (TIMING_SUB_BUCKETS - 1));
+}
+
+static uint32_t timingBucketMidpoint(uint8_t bucket) {
+    if (bucket < TIMING_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const uint8_t shift = (bucket >> TIMING_SUB_BUCKET_BITS) - 1;
+    const uint32_t lower = (uint32_t)(TIMING_SUB_BUCKETS + (bucket & (TIMING_SUB_BUCKETS - 1))) << shift;
+    return lower + ((1UL << shift) >> 1);
+}
+
+void StageTiming::record(uint8_t stage, uint32_t cycles) {
+    if (_count[stage] == 0 || cycles < _min[stage]) {
+        _min[stage] = cycles;
+    }
+    if (cycles > _max[stage]) {
+        _max[stage] = cycles;
+    }
+    _buckets[stage][timingBucket(cycles)]++;
+    _count[stage]++;
+}
+
+void StageTiming::summary(uint8_t stage, timingSummary_t *summary) {
+    const uint32_t count = _count[stage];
+    // Rank of the sample at each percentile, rounded up
+    const uint32_t p50Rank = (count + 1) / 2;
+    const uint32_t p99Rank = count - count / 100;
+    uint32_t seen = 0;
+
+    summary->count = count;
+    summary->min = _min[stage];
+    summary->max = _max[stage];
+    summary->p50 = 0;
+    summary->p99 = 0;
+
+    for (uint8_t bucket = 0; bucket < TIMING_BUCKET_COUNT && seen < p99Rank; bucket++) {
+        const uint32_t before = seen;
+
+        seen += _buckets[stage][bucket];
+        if (before < p50Rank && seen >= p50Rank) {
+            summary->p50 = constrain(timingBucketMidpoint(bucket), summary->min, summary->max);
+        }
+        if (before < p99Rank && seen >= p99Rank) {
+            summary->p99 = constrain(timingBucketMidpoint(bucket), summary->min, summary->max);
+        }
+    }
+}
+
+void StageTiming::reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    memset(_count, 0, sizeof(_count));
+    memset(_min, 0, sizeof(_min));
+    memset(_max, 0, sizeof(_max));
+}
+
+void StageTiming::print() {
+    char line[128];
+    timingSummary_t stats;
+
+    for (uint8_t stage = 0; stage < TIMING_STAGE_COUNT; stage++) {
+        summary(stage, &stats);
+        snprintf(line, sizeof(line), "timing stage=%s count=%lu min=%lu p50=%lu p99=%lu max=%lu unit=cycles\n",
+                 STAGE_NAMES[stage], (unsigned long)stats.count, (unsigned long)stats.min, (unsigned long)stats.p50,
+                 (unsigned long)stats.p99, (unsigned long)stats.max);
+        Serial.print(line);
+    }
+}
+
+const char *StageTiming::getStageName(uint8_t stage) {
+    return (stage < TIMING_STAGE_COUNT) ? STAGE_NAMES[stage] : "";
+}
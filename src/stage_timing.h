@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+#include "Arduino.h"
+
+enum timingStage_e {
+    TIMING_STAGE_SENSOR_READ = 0,
+    TIMING_STAGE_EV_COMPUTE,
+    // Render stages follow lightMeterCompute_e order, pages without a mode after them
+    TIMING_STAGE_RENDER_APERTURE,
+    TIMING_STAGE_RENDER_SHUTTER,
+    TIMING_STAGE_RENDER_ISO,
+    TIMING_STAGE_RENDER_ND,
+    TIMING_STAGE_RENDER_FLICKER,
+    TIMING_STAGE_RENDER_PRESETS,
+    TIMING_STAGE_RENDER_MEMORY,
+    TIMING_STAGE_DISPLAY_FLUSH,
+    TIMING_STAGE_SETTINGS_WRITE,
+    TIMING_STAGE_COUNT
+};
+
+/*
+  Log-linear buckets: values below 4 cycles get their own bucket, above
+  that every power of two is split in 4, so a bucket is at most 25% of its
+  lower bound wide. Covers the whole 32 bit cycle counter
+*/
+#define TIMING_SUB_BUCKET_BITS 2
+#define TIMING_SUB_BUCKETS (1 << TIMING_SUB_BUCKET_BITS)
+#define TIMING_BUCKET_COUNT ((32 - TIMING_SUB_BUCKET_BITS + 1) * TIMING_SUB_BUCKETS)
+
+// Percentiles are bucket midpoints, min and max are exact
+typedef struct timingSummary_s {
+    uint32_t count;
+    uint32_t min;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+} timingSummary_t;
+
+/*
+  Fixed bucket latency histograms in CPU cycles, cheap enough to stay on:
+  a record is two cycle counter reads, a count leading zeros and three
+  stores. Each stage is only recorded from one core, readers on the other
+  one may see a sample half counted, fine for diagnostics
+*/
+class StageTiming {
+    public:
+        static uint32_t start() { return ESP.getCycleCount(); }
+        void stop(uint8_t stage, uint32_t startCycles) { record(stage, ESP.getCycleCount() - startCycles); }
+        void record(uint8_t stage, uint32_t cycles);
+        void summary(uint8_t stage, timingSummary_t *summary);
+        void reset();
+        // One "timing stage=... unit=cycles" line per stage
+        void print();
+        static const char *getStageName(uint8_t stage);
+    private:
+        uint32_t _buckets[TIMING_STAGE_COUNT][TIMING_BUCKET_COUNT] = {};
+        uint32_t _count[TIMING_STAGE_COUNT] = {};
+        uint32_t _min[TIMING_STAGE_COUNT] = {};
+        uint32_t _max[TIMING_STAGE_COUNT] = {};
+};
+
+extern StageTiming stageTiming;
+
+#endif
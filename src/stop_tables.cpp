@@ -0,0 +1,276 @@
+#include "stop_tables.h"
+#include <utility>
+
+/*
+  Every table below is generated by the compiler and lives in flash. A
+  series is defined by its quantity and increment only, adding an increment
+  to stopIncrement_e and STOP_STEPS_PER_STOP adds its tables here as well
+*/
+
+static constexpr int8_t STOP_MIN[STOP_QUANTITY_COUNT] = {SHUTTER_STOP_MIN, APERTURE_STOP_MIN, ISO_STOP_MIN};
+static constexpr int8_t STOP_MAX[STOP_QUANTITY_COUNT] = {SHUTTER_STOP_MAX, APERTURE_STOP_MAX, ISO_STOP_MAX};
+
+// 2^(i / 12), Av steps are half the size of Tv and Sv steps
+static constexpr double EXP2_TWELFTHS[12] = {
+    1.0, 1.0594630943592953, 1.1224620483093730, 1.1892071150027210,
+    1.2599210498948732, 1.3348398541700344, 1.4142135623730951, 1.4983070768766815,
+    1.5874010519681994, 1.6817928305074290, 1.7817974362806785, 1.8877486253633868
+};
+
+/*
+  R20 preferred numbers as photography rounds them (1/125, 1/320, ISO 640),
+  x100. The last one closes the decade
+*/
+static constexpr uint16_t PREFERRED_NUMBERS[] = {
+    100, 110, 125, 140, 160, 180, 200, 220, 250, 280,
+    320, 360, 400, 450, 500, 560, 640, 710, 800, 900,
+    1000
+};
+
+static constexpr double exp2Twelfths(int32_t twelfths) {
+    int32_t octaves = twelfths / 12;
+    int32_t rest = twelfths % 12;
+
+    if (rest < 0) {
+        rest += 12;
+        octaves--;
+    }
+
+    double value = EXP2_TWELFTHS[rest];
+    for (; octaves > 0; octaves--) {
+        value *= 2;
+    }
+    for (; octaves < 0; octaves++) {
+        value /= 2;
+    }
+    return value;
+}
+
+// Nearest preferred number on a log scale, for values of 1 and up
+static constexpr double snapPreferred(double value) {
+    double decade = 1;
+    while (value >= decade * 10) {
+        decade *= 10;
+    }
+
+    const double mantissa = value / decade * 100;
+    for (size_t i = 0; i + 1 < sizeof(PREFERRED_NUMBERS) / sizeof(PREFERRED_NUMBERS[0]); i++) {
+        const double low = PREFERRED_NUMBERS[i];
+        const double high = PREFERRED_NUMBERS[i + 1];
+
+        if (mantissa <= high) {
+            return ((mantissa * mantissa < low * high) ? low : high) * decade / 100;
+        }
+    }
+    return value;
+}
+
+static constexpr uint32_t roundPositive(double value) {
+    return (uint32_t)(value + 0.5);
+}
+
+static constexpr void appendChar(stopEntry_t &entry, size_t &length, char c) {
+    if (length < STOP_LABEL_SIZE - 1) {
+        entry.label[length++] = c;
+    }
+}
+
+static constexpr void appendNumber(stopEntry_t &entry, size_t &length, uint32_t value) {
+    char digits[10] = {};
+    size_t count = 0;
+
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0) {
+        appendChar(entry, length, digits[--count]);
+    }
+}
+
+static constexpr void appendTenths(stopEntry_t &entry, size_t &length, uint32_t tenths) {
+    appendNumber(entry, length, tenths / 10);
+    appendChar(entry, length, '.');
+    appendChar(entry, length, '0' + tenths % 10);
+}
+
+/*
+  Marked full stop times, 1/15 to 1/60 and the 1/125 series instead of
+  powers of two. The same numbers count seconds on the slow side
+*/
+static constexpr double shutterFullStop(int32_t stops) {
+    const double exact = exp2Twelfths(stops * 12);
+
+    if (stops <= 3) {
+        return exact;
+    }
+    if (stops <= 6) {
+        return exact * 15 / 16;
+    }
+    return 125 * exp2Twelfths((stops - 7) * 12);
+}
+
+static constexpr stopEntry_t shutterEntry(int32_t index, uint8_t steps) {
+    stopEntry_t entry = {};
+    size_t length = 0;
+    const bool fullStop = index % steps == 0;
+    const int32_t magnitude = (index < 0) ? -index : index;
+    // Denominator on the fast side, seconds on the slow side
+    const double nominal = fullStop ? shutterFullStop(magnitude / steps) : snapPreferred(exp2Twelfths(magnitude * 12 / steps));
+
+    entry.value = (float)exp2Twelfths(-index * 12 / steps);
+
+    if (index > 0 && (fullStop || nominal >= 4)) {
+        appendChar(entry, length, '1');
+        appendChar(entry, length, '/');
+        if (nominal >= 10000) {
+            appendNumber(entry, length, (uint32_t)(nominal / 1000));
+            appendChar(entry, length, 'k');
+        } else {
+            appendNumber(entry, length, roundPositive(nominal));
+        }
+    } else if (index > 0) {
+        // 0.3s to 0.8s are marked in seconds
+        appendTenths(entry, length, roundPositive(10 / nominal));
+    } else if (nominal >= 4 || nominal == (uint32_t)nominal) {
+        appendNumber(entry, length, roundPositive(nominal));
+    } else {
+        appendTenths(entry, length, roundPositive(nominal * 10));
+    }
+    return entry;
+}
+
+typedef struct apertureMark_s {
+    // Av position in 1/12 stops, f-number 2^(twelfths / 12)
+    int8_t twelfths;
+    char label[STOP_LABEL_SIZE];
+} apertureMark_t;
+
+/*
+  Marked stops that two rounded digits get wrong: the third stops below f/1
+  would both read 0.6, f/1.26 and f/3.56 are marked 1.2 and 3.5 and the
+  half stop f/3.36 is marked 3.3
+*/
+static constexpr apertureMark_t APERTURE_MARKS[] = {
+    {-10, "0.56"},
+    {-8, "0.63"},
+    {4, "1.2"},
+    {21, "3.3"},
+    {22, "3.5"}
+};
+
+/*
+  Full stops keep the marked series 5.6, 11, 22, those are truncated, the
+  stops in between are rounded to two digits unless they are marked
+  otherwise
+*/
+static constexpr stopEntry_t apertureEntry(int32_t index, uint8_t steps) {
+    stopEntry_t entry = {};
+    size_t length = 0;
+    const bool fullStop = index % steps == 0;
+    const int32_t twelfths = index * 6 / steps;
+    const double exact = exp2Twelfths(twelfths);
+    const double rounding = fullStop ? 0 : 0.5;
+    const uint32_t tenths = (exact < 10) ? (uint32_t)(exact * 10 + rounding) : (uint32_t)(exact + rounding) * 10;
+
+    entry.value = (float)exact;
+
+    for (const apertureMark_t &mark : APERTURE_MARKS) {
+        if (mark.twelfths == twelfths) {
+            for (size_t i = 0; mark.label[i] != '\0'; i++) {
+                appendChar(entry, length, mark.label[i]);
+            }
+            return entry;
+        }
+    }
+
+    // "1.0" but "2" and "11"
+    if (tenths < 100 && (tenths % 10 != 0 || tenths == 10)) {
+        appendTenths(entry, length, tenths);
+    } else {
+        appendNumber(entry, length, tenths / 10);
+    }
+    return entry;
+}
+
+static constexpr stopEntry_t isoEntry(int32_t index, uint8_t steps) {
+    stopEntry_t entry = {};
+    size_t length = 0;
+    const double exact = 100 * exp2Twelfths(index * 12 / steps);
+
+    entry.value = (float)exact;
+    appendNumber(entry, length, roundPositive((index % steps == 0) ? exact : snapPreferred(exact)));
+    return entry;
+}
+
+template <size_t Count> struct stopEntries_s {
+    stopEntry_t entries[Count];
+};
+
+template <size_t Count> static constexpr stopEntries_s<Count> buildEntries(uint8_t quantity, int32_t minIndex, uint8_t steps) {
+    stopEntries_s<Count> table = {};
+
+    for (size_t i = 0; i < Count; i++) {
+        const int32_t index = minIndex + (int32_t)i;
+
+        if (quantity == STOP_QUANTITY_SHUTTER) {
+            table.entries[i] = shutterEntry(index, steps);
+        } else if (quantity == STOP_QUANTITY_APERTURE) {
+            table.entries[i] = apertureEntry(index, steps);
+        } else {
+            table.entries[i] = isoEntry(index, steps);
+        }
+    }
+    return table;
+}
+
+template <uint8_t Quantity, uint8_t Increment> struct stopTable_s {
+    static constexpr uint8_t steps = STOP_STEPS_PER_STOP[Increment];
+    static_assert(6 % steps == 0, "Av steps have to land on 1/12 stops");
+
+    static constexpr int8_t minIndex = STOP_MIN[Quantity] * steps;
+    static constexpr int8_t maxIndex = STOP_MAX[Quantity] * steps;
+    static constexpr stopEntries_s<maxIndex - minIndex + 1> table =
+        buildEntries<maxIndex - minIndex + 1>(Quantity, minIndex, steps);
+    static constexpr stopSeries_t series = {table.entries, minIndex, maxIndex};
+};
+
+// Every quantity and increment, series of quantity q and increment i at q * STOP_INCREMENT_COUNT + i
+template <class Sequence> struct stopRegistry_s;
+
+template <size_t... Series> struct stopRegistry_s<std::index_sequence<Series...>> {
+    static constexpr stopSeries_t series[] = {
+        stopTable_s<Series / STOP_INCREMENT_COUNT, Series % STOP_INCREMENT_COUNT>::series...
+    };
+};
+
+typedef stopRegistry_s<std::make_index_sequence<STOP_QUANTITY_COUNT * STOP_INCREMENT_COUNT>> stopRegistry_t;
+
+const stopSeries_t &stopSeries(uint8_t quantity, uint8_t increment) {
+    quantity = (quantity < STOP_QUANTITY_COUNT) ? quantity : (uint8_t)STOP_QUANTITY_SHUTTER;
+    increment = (increment < STOP_INCREMENT_COUNT) ? increment : (uint8_t)STOP_INCREMENT_FULL;
+    return stopRegistry_t::series[quantity * STOP_INCREMENT_COUNT + increment];
+}
+
+const stopEntry_t &stopEntry(uint8_t quantity, uint8_t increment, int16_t index) {
+    const stopSeries_t &series = stopSeries(quantity, increment);
+
+    index = constrain(index, series.minIndex, series.maxIndex);
+    return series.entries[index - series.minIndex];
+}
+
+int8_t stopConvertIndex(int8_t index, uint8_t from, uint8_t to) {
+    from = (from < STOP_INCREMENT_COUNT) ? from : (uint8_t)STOP_INCREMENT_FULL;
+    to = (to < STOP_INCREMENT_COUNT) ? to : (uint8_t)STOP_INCREMENT_FULL;
+
+    // Nearest step, rounded half up on both sides of zero
+    const int32_t numerator = 2 * index * STOP_STEPS_PER_STOP[to] + STOP_STEPS_PER_STOP[from];
+    const int32_t denominator = 2 * STOP_STEPS_PER_STOP[from];
+    int32_t converted = numerator / denominator;
+
+    if (numerator % denominator < 0) {
+        converted--;
+    }
+    return converted;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifndef STOP_TABLES_H
+#define STOP_TABLES_H
+
+#include "Arduino.h"
+
+enum stopIncrement_e {
+    STOP_INCREMENT_FULL = 0,
+    STOP_INCREMENT_HALF,
+    STOP_INCREMENT_THIRD,
+    STOP_INCREMENT_COUNT
+};
+
+enum stopQuantity_e {
+    STOP_QUANTITY_SHUTTER = 0,
+    STOP_QUANTITY_APERTURE,
+    STOP_QUANTITY_ISO,
+    STOP_QUANTITY_COUNT
+};
+
+// Steps per stop of every increment, index 0 of every series is 1s, f/1 and ISO 100
+static constexpr uint8_t STOP_STEPS_PER_STOP[STOP_INCREMENT_COUNT] = {1, 2, 3};
+
+// Series ends in full stops: 60s to 1/32000, f/0.5 to f/32, ISO 25 to 102400
+#define SHUTTER_STOP_MIN -6
+#define SHUTTER_STOP_MAX 15
+#define APERTURE_STOP_MIN -2
+#define APERTURE_STOP_MAX 10
+#define ISO_STOP_MIN -2
+#define ISO_STOP_MAX 10
+
+// Longest label is "1/12500" shortened to "1/12k", "102400" for ISO
+#define STOP_LABEL_SIZE 8
+
+typedef struct stopEntry_s {
+    // Nominal value as marked on cameras and lenses
+    char label[STOP_LABEL_SIZE];
+    // Exact value: exposure time in seconds, f-number or ISO
+    float value;
+} stopEntry_t;
+
+typedef struct stopSeries_s {
+    const stopEntry_t *entries;
+    int8_t minIndex;
+    int8_t maxIndex;
+} stopSeries_t;
+
+const stopSeries_t &stopSeries(uint8_t quantity, uint8_t increment);
+// Clamped to the series, callers check the range first where it matters
+const stopEntry_t &stopEntry(uint8_t quantity, uint8_t increment, int16_t index);
+// Same exposure in steps of another increment, nearest step
+int8_t stopConvertIndex(int8_t index, uint8_t from, uint8_t to);
+
+#endif
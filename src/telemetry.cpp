@@ -0,0 +1,193 @@
+#include "telemetry.h"
+#include "crc16.h"
+#include "byte_order.h"
+
+size_t cobsEncode(const uint8_t *src, size_t size, uint8_t *dst) {
+    size_t codeIndex = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < size; i++) {
+        if (src[i] != 0) {
+            dst[out++] = src[i];
+            code++;
+        }
+        if (src[i] == 0 || code == 0xFF) {
+            dst[codeIndex] = code;
+            codeIndex = out++;
+            code = 1;
+        }
+    }
+    dst[codeIndex] = code;
+
+    return out;
+}
+
+size_t cobsDecode(const uint8_t *src, size_t size, uint8_t *dst) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < size) {
+        const uint8_t code = src[in++];
+
+        if (code == 0 || in + code - 1 > size) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (src[in] == 0) {
+                return 0;
+            }
+            dst[out++] = src[in++];
+        }
+        // A full block is not followed by an implicit zero
+        if (code < 0xFF && in < size) {
+            dst[out++] = 0;
+        }
+    }
+
+    return out;
+}
+
+static void putFloat(uint8_t *dst, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putLe(dst, bits, 4);
+}
+
+static float getFloat(const uint8_t *src) {
+    const uint32_t bits = getLe(src, 4);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void encodeMeasurement(uint8_t *payload, const measurement_t &measurement, uint32_t timestamp, uint32_t sequence) {
+    putLe(payload, timestamp, 4);
+    putLe(payload + 4, sequence, 4);
+    putFloat(payload + 8, measurement.lux);
+    putFloat(payload + 12, measurement.ev);
+    putLe(payload + 16, measurement.counts, 2);
+    payload[18] = measurement.gain;
+    payload[19] = measurement.integrationTime;
+    putLe(payload + 20, (uint16_t)measurement.outputValue, 2);
+    payload[22] = measurement.settings.isoIndex;
+    payload[23] = measurement.settings.apertureIndex;
+    payload[24] = measurement.settings.shutterIndex;
+    payload[25] = measurement.settings.ndFilterIndex;
+    payload[26] = measurement.settings.type;
+    // Mode in the low nibble, stop increment in the high one
+    payload[27] = measurement.settings.mode | (measurement.settings.stopIncrement << 4);
+    putLe(payload + 28, measurement.flicker.frequencyTenths, 2);
+    putLe(payload + 30, measurement.flicker.depthPerMille, 2);
+}
+
+static void decodeMeasurement(const uint8_t *payload, telemetryMeasurement_t *decoded) {
+    measurement_t &measurement = decoded->measurement;
+
+    decoded->timestamp = getLe(payload, 4);
+    decoded->sequence = getLe(payload + 4, 4);
+    measurement.lux = getFloat(payload + 8);
+    measurement.ev = getFloat(payload + 12);
+    measurement.counts = getLe(payload + 16, 2);
+    measurement.gain = payload[18];
+    measurement.integrationTime = payload[19];
+    measurement.outputValue = (int16_t)getLe(payload + 20, 2);
+    measurement.settings.isoIndex = (int8_t)payload[22];
+    measurement.settings.apertureIndex = (int8_t)payload[23];
+    measurement.settings.shutterIndex = (int8_t)payload[24];
+    measurement.settings.ndFilterIndex = (int8_t)payload[25];
+    measurement.settings.type = (lightMeterMode_e)payload[26];
+    measurement.settings.mode = (lightMeterCompute_e)(payload[27] & 0x0F);
+    measurement.settings.stopIncrement = payload[27] >> 4;
+    measurement.flicker.frequencyTenths = getLe(payload + 28, 2);
+    measurement.flicker.depthPerMille = getLe(payload + 30, 2);
+}
+
+void Telemetry::setRate(uint8_t hz) {
+    _rate = (hz > TELEMETRY_RATE_MAX_HZ) ? TELEMETRY_RATE_MAX_HZ : hz;
+}
+
+void Telemetry::loop() {
+    if (_rate == 0 || millis() - _lastSend < 1000 / _rate) {
+        return;
+    }
+
+    measurement_t measurement;
+    const uint32_t sequence = measurementSnapshot.read(&measurement);
+
+    // Snapshots only change at the sensor rate, never send one twice
+    if (sequence == _lastSequence) {
+        return;
+    }
+
+    _lastSend = millis();
+    _lastSequence = sequence;
+    send(measurement, sequence);
+}
+
+bool Telemetry::send(const measurement_t &measurement, uint32_t sequence) {
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint8_t encoded[TELEMETRY_ENCODED_MAX];
+
+    frame[0] = TELEMETRY_FRAME_MEASUREMENT;
+    putLe(frame + 1, _frame++, 2);
+    encodeMeasurement(frame + TELEMETRY_HEADER_SIZE, measurement, millis(), sequence);
+    putLe(frame + TELEMETRY_FRAME_MAX - TELEMETRY_CRC_SIZE, crc16Ccitt(frame, TELEMETRY_FRAME_MAX - TELEMETRY_CRC_SIZE), 2);
+
+    size_t size = cobsEncode(frame, TELEMETRY_FRAME_MAX, encoded);
+    encoded[size++] = 0;
+
+    // Partial frames would only cost the receiver a CRC error, drop it whole
+    if (Serial.availableForWrite() < (int)size) {
+        _droppedFrames++;
+        return false;
+    }
+
+    Serial.write(encoded, size);
+    _sentFrames++;
+    return true;
+}
+
+bool TelemetryParser::feed(uint8_t byte) {
+    if (byte != 0) {
+        if (_size < sizeof(_buffer)) {
+            _buffer[_size++] = byte;
+        } else {
+            _overflow = true;
+        }
+        return false;
+    }
+
+    const bool valid = !_overflow && _size > 0 && decodeFrame();
+    if (!valid && (_size > 0 || _overflow)) {
+        _crcErrors++;
+    }
+    _size = 0;
+    _overflow = false;
+
+    return valid;
+}
+
+bool TelemetryParser::decodeFrame() {
+    uint8_t frame[TELEMETRY_ENCODED_MAX];
+    const size_t size = cobsDecode(_buffer, _size, frame);
+
+    if (size != TELEMETRY_FRAME_MAX || frame[0] != TELEMETRY_FRAME_MEASUREMENT) {
+        return false;
+    }
+    if (getLe(frame + size - TELEMETRY_CRC_SIZE, 2) != crc16Ccitt(frame, size - TELEMETRY_CRC_SIZE)) {
+        return false;
+    }
+
+    const uint16_t counter = getLe(frame + 1, 2);
+    if (_synced) {
+        _lostFrames += (uint16_t)(counter - _measurement.frame - 1);
+    }
+    _synced = true;
+
+    _measurement.frame = counter;
+    decodeMeasurement(frame + TELEMETRY_HEADER_SIZE, &_measurement);
+    _frames++;
+
+    return true;
+}
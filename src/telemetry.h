@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "Arduino.h"
+#include "measurement.h"
+
+/*
+  UART driver TX ring buffer. Frames are only written when they fit, the
+  driver drains it from its interrupt, so sending never blocks the UI loop
+*/
+#define TELEMETRY_TX_BUFFER_SIZE 1024
+#define TELEMETRY_RATE_MAX_HZ 50
+
+/*
+  Frame before COBS: type, frame counter (u16), payload, CRC16 (CCITT-FALSE)
+  over everything before it. All fields little endian. After COBS the frame
+  contains no zero byte and a single 0x00 terminates it
+*/
+#define TELEMETRY_FRAME_MEASUREMENT 0x01
+#define TELEMETRY_HEADER_SIZE 3
+#define TELEMETRY_CRC_SIZE 2
+#define TELEMETRY_MEASUREMENT_PAYLOAD_SIZE 32
+#define TELEMETRY_FRAME_MAX (TELEMETRY_HEADER_SIZE + TELEMETRY_MEASUREMENT_PAYLOAD_SIZE + TELEMETRY_CRC_SIZE)
+// COBS adds one byte per 254 plus the delimiter
+#define TELEMETRY_ENCODED_MAX (TELEMETRY_FRAME_MAX + TELEMETRY_FRAME_MAX / 254 + 2)
+
+size_t cobsEncode(const uint8_t *src, size_t size, uint8_t *dst);
+// Returns the decoded size, 0 for a malformed frame
+size_t cobsDecode(const uint8_t *src, size_t size, uint8_t *dst);
+
+// Measurement frame contents on the receiving side
+typedef struct telemetryMeasurement_s {
+    uint16_t frame;
+    uint32_t timestamp;
+    uint32_t sequence;
+    measurement_t measurement;
+} telemetryMeasurement_t;
+
+/*
+  Streams the latest measurement snapshot at the configured rate. A frame
+  that does not fit the TX buffer is dropped and counted, the frame counter
+  still moves so the receiver sees the gap
+*/
+class Telemetry {
+    public:
+        // 0 turns the stream off, capped at TELEMETRY_RATE_MAX_HZ
+        void setRate(uint8_t hz);
+        uint8_t getRate() { return _rate; }
+        void loop();
+        bool send(const measurement_t &measurement, uint32_t sequence);
+        uint32_t getSentFrames() { return _sentFrames; }
+        uint32_t getDroppedFrames() { return _droppedFrames; }
+    private:
+        uint8_t _rate = 0;
+        uint32_t _lastSend = 0;
+        uint32_t _lastSequence = 0;
+        uint16_t _frame = 0;
+        uint32_t _sentFrames = 0;
+        uint32_t _droppedFrames = 0;
+};
+
+/*
+  Receiving side, fed one byte at a time. Used by the host tools, kept next
+  to the encoder so both always agree on the format
+*/
+class TelemetryParser {
+    public:
+        // Returns true when a valid measurement frame was completed
+        bool feed(uint8_t byte);
+        const telemetryMeasurement_t &getMeasurement() { return _measurement; }
+        uint32_t getFrames() { return _frames; }
+        uint32_t getCrcErrors() { return _crcErrors; }
+        uint32_t getLostFrames() { return _lostFrames; }
+    private:
+        bool decodeFrame();
+        uint8_t _buffer[TELEMETRY_ENCODED_MAX];
+        size_t _size = 0;
+        bool _overflow = false;
+        bool _synced = false;
+        telemetryMeasurement_t _measurement;
+        uint32_t _frames = 0;
+        uint32_t _crcErrors = 0;
+        uint32_t _lostFrames = 0;
+};
+
+#endif
@@ -5,6 +5,8 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include "stop_tables.h"
+
 enum lightMeterMode_e {
     LIGHT_METER_TYPE_INCIDENT = 0,
     LIGHT_METER_TYPE_REFLECTED,
@@ -16,6 +18,7 @@ enum lightMeterCompute_e {
     LIGHT_METER_MODE_SHUTTER,
     LIGHT_METER_MODE_ISO,
     LIGHT_METER_MODE_ND,
+    LIGHT_METER_MODE_FLICKER,
     LIGHT_METER_MODE_COUNT
 };
 
@@ -25,6 +28,10 @@ enum oledPages_e {
     OLED_PAGE_SHUTTER,
     OLED_PAGE_ISO,
     OLED_PAGE_ND,
+    OLED_PAGE_FLICKER,
+    OLED_PAGE_PRESETS,
+    OLED_PAGE_MEMORY,
+    OLED_PAGE_DIAGNOSTICS,
     OLED_PAGE_ERROR
 };
 
@@ -38,33 +45,36 @@ enum adjustSetting_e {
     ADJUST_SETTING_COUNT
 };
 
+enum luxFilter_e {
+    LUX_FILTER_NONE = 0,
+    LUX_FILTER_EMA,
+    LUX_FILTER_MEDIAN,
+    LUX_FILTER_COUNT
+};
+
 typedef struct settings_s
 {
+    // Steps of stopIncrement into the stop tables, ND filters in full stops
 	int8_t isoIndex = 0;
     int8_t apertureIndex = 0;
-    int8_t shutterIndex = 6;
+    int8_t shutterIndex = 18;
     int8_t ndFilterIndex = 0;
 
     lightMeterMode_e type = LIGHT_METER_TYPE_INCIDENT;
     lightMeterCompute_e mode = LIGHT_METER_MODE_APERTURE;
     adjustSetting_e adjustSetting = ADJUST_SETTING_ISO;
 
-} settings_t;
+    // luxFilter_e, stored as a byte to keep the record small
+    uint8_t luxFilter = LUX_FILTER_EMA;
+    // EMA time constant or median window, in sensor samples
+    uint8_t luxFilterSamples = 2;
 
-#define ISO_TABLE_OFFSET 2
-#define SHUTTER_TABLE_OFFSET 6
+    // stopIncrement_e, records written before it existed read as 0, full stops
+    uint8_t stopIncrement = STOP_INCREMENT_THIRD;
 
-#define SHUTTER_INDEX_MIN -6
-#define SHUTTER_INDEX_MAX 15 
-
-#define ISO_INDEX_MIN -2
-#define ISO_INDEX_MAX 10
+} settings_t;
 
 #define ND_FILTER_INDEX_MIN 0
 #define ND_FILTER_INDEX_MAX 10
 
-#define APERTURE_INDEX_MIN 0
-#define APERTURE_INDEX_MAX 10
-#define APERTURE_TABLE_OFFSET 0
-
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*
+  Cold boot until the first reading is on the panel: the sensor has to be
+  started before the display and the first EV may take no longer than one
+  conversion in the initial sensor range
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "boot_timing.h"
+
+// One conversion in the initial range and its start margin, a second conversion would not fit
+#define BOOT_TEST_FIRST_EV_MS 150
+#define BOOT_TEST_TIMEOUT_MS 2000
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_first_ev_on_time() {
+    uint32_t nextSensorUpdate = 0;
+
+    setup();
+
+    for (uint32_t t = millis(); t < BOOT_TEST_TIMEOUT_MS && !bootTiming.isReached(BOOT_PHASE_FIRST_FRAME); t = millis()) {
+        if (t >= nextSensorUpdate) {
+            nextSensorUpdate = t + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+    }
+
+    bootTiming.print();
+
+    TEST_ASSERT_TRUE(bootTiming.isReached(BOOT_PHASE_FIRST_FRAME));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(BOOT_TEST_FIRST_EV_MS, bootTiming.getMicros(BOOT_PHASE_FIRST_EV) / 1000);
+    TEST_ASSERT_LESS_THAN_UINT32(bootTiming.getMicros(BOOT_PHASE_DISPLAY_READY), bootTiming.getMicros(BOOT_PHASE_SENSOR_STARTED));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_ev_on_time);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+/*
+  Scripted calibration of a simulated sensor with a response error: points
+  are taken over the simulated Serial at a few levels against an ideal
+  reference meter, then levels in between have to meter within
+  CALIBRATION_TEST_MAX_ERROR on the float and the fixed point path, also
+  after the points are reloaded from NVS
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "calibration.h"
+#include "exposure.h"
+#include "measurement.h"
+#include "power_manager.h"
+
+// Reads 20% high in the dark, 10% low in daylight
+#define CALIBRATION_TEST_SCALE 1.2f
+#define CALIBRATION_TEST_SLOPE 0.96f
+// A reference spot meter on a gray card reads this far below the nominal reflected model
+#define CALIBRATION_TEST_REFLECTED_BIAS -0.7f
+// Long enough for a range change and the lux filter
+#define CALIBRATION_TEST_SETTLE_MS 3000
+#define CALIBRATION_TEST_MAX_ERROR 0.05f
+
+// Where the points are taken, then levels between and on them
+static const float CALIBRATION_TEST_POINT_LUX[] = {1.0f, 20.0f, 400.0f, 8000.0f, 60000.0f};
+static const float CALIBRATION_TEST_LEVEL_LUX[] = {1.0f, 3.0f, 55.0f, 400.0f, 1500.0f, 25000.0f, 60000.0f};
+
+extern settings_t settings;
+extern PowerManager powerManager;
+
+static uint32_t calibrationTestNextUpdate = 0;
+
+// log2 lux of a correction table entry
+static int32_t calibrationTestEntry(uint16_t i) {
+    return CALIBRATION_LUT_MIN_STOPS * EXPOSURE_FIXED_ONE + ((int32_t)i << (EXPOSURE_FIXED_BITS - CALIBRATION_LUT_STEP_BITS));
+}
+
+static float calibrationTestReference(uint8_t type, float lux) {
+    return (type == LIGHT_METER_TYPE_REFLECTED) ? log2f(lux) + EXPOSURE_REFLECTED_OFFSET + CALIBRATION_TEST_REFLECTED_BIAS
+                                                : log2f(lux) - EXPOSURE_INCIDENT_OFFSET;
+}
+
+// The meter held still under lux until the reading settled, someone is at the buttons
+static void calibrationTestSettle(float lux) {
+    const uint32_t end = millis() + CALIBRATION_TEST_SETTLE_MS;
+
+    simSetLux(lux);
+    powerManager.activity();
+
+    while (millis() < end) {
+        if (millis() >= calibrationTestNextUpdate) {
+            calibrationTestNextUpdate = millis() + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+    }
+}
+
+static void calibrationTestCommand(const char *command) {
+    uint8_t buf[256];
+
+    simSerialInject((const uint8_t *)command, strlen(command));
+    loop();
+    // Point listings are not part of the report
+    while (simSerialCaptured(buf, sizeof(buf)) > 0) {
+    }
+}
+
+// Largest metering error of both types over the test levels
+static float calibrationTestPass(uint8_t luxFilter) {
+    float maxError = 0;
+
+    settings.luxFilter = luxFilter;
+    settingsSnapshot.write(settings);
+
+    for (float lux : CALIBRATION_TEST_LEVEL_LUX) {
+        measurement_t measurement;
+
+        calibrationTestSettle(lux);
+        measurementSnapshot.read(&measurement);
+
+        const float incidentError = measurement.incidentEv - calibrationTestReference(LIGHT_METER_TYPE_INCIDENT, lux);
+        const float reflectedError = measurement.reflectedEv - calibrationTestReference(LIGHT_METER_TYPE_REFLECTED, lux);
+        maxError = fmaxf(maxError, fmaxf(fabsf(incidentError), fabsf(reflectedError)));
+    }
+    return maxError;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// The suite runs in order on one firmware instance, each test picks up where the last one left off
+static void test_uncalibrated_off() {
+    TEST_ASSERT_TRUE(calibrationTestPass(LUX_FILTER_EMA) > CALIBRATION_TEST_MAX_ERROR);
+}
+
+// A point per type and level, each saved to NVS once
+static void test_points_taken() {
+    char command[32];
+
+    for (float lux : CALIBRATION_TEST_POINT_LUX) {
+        calibrationTestSettle(lux);
+        snprintf(command, sizeof(command), "ci%.2f\n", calibrationTestReference(LIGHT_METER_TYPE_INCIDENT, lux));
+        calibrationTestCommand(command);
+        snprintf(command, sizeof(command), "cr%.2f\n", calibrationTestReference(LIGHT_METER_TYPE_REFLECTED, lux));
+        calibrationTestCommand(command);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(2 * sizeof(CALIBRATION_TEST_POINT_LUX) / sizeof(float), calibration.getPointCount());
+    TEST_ASSERT_EQUAL_UINT32(calibration.getPointCount(), simGetNvsWrites());
+}
+
+static void test_calibrated_float() {
+    TEST_ASSERT_FLOAT_WITHIN(CALIBRATION_TEST_MAX_ERROR, 0, calibrationTestPass(LUX_FILTER_EMA));
+}
+
+static void test_calibrated_fixed() {
+    TEST_ASSERT_FLOAT_WITHIN(CALIBRATION_TEST_MAX_ERROR, 0, calibrationTestPass(LUX_FILTER_NONE));
+}
+
+// A reboot has to expand the same table from NVS
+static void test_reload() {
+    static int32_t corrections[LIGHT_METER_TYPE_COUNT][CALIBRATION_LUT_COUNT];
+
+    for (uint8_t type = 0; type < LIGHT_METER_TYPE_COUNT; type++) {
+        for (uint16_t i = 0; i < CALIBRATION_LUT_COUNT; i++) {
+            corrections[type][i] = calibration.getCorrection(type, calibrationTestEntry(i));
+        }
+    }
+    calibration.begin();
+    for (uint8_t type = 0; type < LIGHT_METER_TYPE_COUNT; type++) {
+        for (uint16_t i = 0; i < CALIBRATION_LUT_COUNT; i++) {
+            TEST_ASSERT_EQUAL_INT32(corrections[type][i], calibration.getCorrection(type, calibrationTestEntry(i)));
+        }
+    }
+}
+
+// Cleared, the nominal model is back after a reboot too
+static void test_cleared() {
+    calibrationTestCommand("cx\n");
+    calibration.begin();
+
+    TEST_ASSERT_EQUAL_UINT8(0, calibration.getPointCount());
+    TEST_ASSERT_EQUAL_INT32(0, calibration.getCorrection(LIGHT_METER_TYPE_INCIDENT, 0));
+}
+
+int main() {
+    simSetSensorError(CALIBRATION_TEST_SCALE, CALIBRATION_TEST_SLOPE);
+    setup();
+    simSerialCapture(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_uncalibrated_off);
+    RUN_TEST(test_points_taken);
+    RUN_TEST(test_calibrated_float);
+    RUN_TEST(test_calibrated_fixed);
+    RUN_TEST(test_reload);
+    RUN_TEST(test_cleared);
+    return UNITY_END();
+}
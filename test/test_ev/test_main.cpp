@@ -0,0 +1,48 @@
+/*
+  Fixed point counts to EV conversion against the float one, for every
+  count in every auto-ranging sensor range
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "exposure.h"
+#include "light_sensor.h"
+
+// Fixed point log2(lux) has to stay this close to log2f of the float lux
+#define EV_TEST_MAX_ERROR 0.01f
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_every_count() {
+    settings_t settings;
+    char message[64];
+
+    for (uint8_t rangeIndex = 0; rangeIndex < LightSensor::getRangeCount(); rangeIndex++) {
+        const lightSensorRange_t &range = LightSensor::getRange(rangeIndex);
+        float maxError = 0;
+
+        for (uint32_t counts = 1; counts <= LIGHT_SENSOR_COUNTS_SATURATED; counts++) {
+            exposureResult_t reference;
+            exposureResult_t fixed;
+
+            exposureSolve(LightSensor::countsToLux(counts, rangeIndex), settings, &reference);
+            exposureSolveFixed(LightSensor::countsToLog2Lux(counts, range.gain, range.integrationTime), settings, &fixed);
+
+            const float error = fabsf(fixed.baseEv - reference.baseEv);
+            maxError = (error > maxError) ? error : maxError;
+        }
+
+        snprintf(message, sizeof(message), "range %u max_error=%.5f", rangeIndex, maxError);
+        TEST_ASSERT_TRUE_MESSAGE(maxError <= EV_TEST_MAX_ERROR, message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_count);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+/*
+  Flicker analyzer on synthetic modulated light and once end to end
+  through the sensor task with the simulated VEML7700. Visible flicker has
+  to be found within half a bin and its depth, after the sensor's own
+  integration, within 15%
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "flicker.h"
+#include "measurement.h"
+
+#define FLICKER_TEST_TIMEOUT_MS 5000
+
+typedef struct flickerCase_s {
+    const char *name;
+    float frequencyHz;
+    float depth;
+    // Expected to be reported as flicker, false where the sensor can't see it
+    bool visible;
+} flickerCase_t;
+
+static const flickerCase_t FLICKER_CASES[] = {
+    {"steady", 0, 0, false},
+    {"tube_2.5hz", 2.5f, 0.9f, true},
+    {"pwm_beat_8hz", 8.0f, 0.3f, true},
+    {"dimmer_15hz", 15.0f, 0.2f, true},
+    {"shallow_5hz", 5.0f, 0.01f, false},
+    // 2.5 periods per window, what's left folds onto Nyquist
+    {"mains_100hz", 100.0f, 1.0f, false},
+    // Whole periods per window, integrated away
+    {"mains_120hz", 120.0f, 1.0f, false}
+};
+
+static const float FLICKER_BIN_HZ = 1000.0f / (FLICKER_SAMPLE_PERIOD_MS * FLICKER_SAMPLE_COUNT);
+
+// Sensor samples of a modulated scene, each averaged over its 25ms window
+static void flickerTrace(FlickerAnalyzer *analyzer, float frequencyHz, float depth) {
+    simSetLux(1000.0f);
+    simSetFlicker(frequencyHz, depth);
+
+    analyzer->reset();
+    for (uint32_t i = 0; i < FLICKER_SAMPLE_COUNT; i++) {
+        const uint32_t start = 1000 + i * FLICKER_SAMPLE_PERIOD_MS;
+        analyzer->addSample(lroundf(simGetAverageLux(start, start + FLICKER_SAMPLE_PERIOD_MS) * 10));
+    }
+
+    simSetFlicker(0, 0);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_synthetic_traces() {
+    FlickerAnalyzer analyzer;
+
+    for (const flickerCase_t &flickerCase : FLICKER_CASES) {
+        flickerResult_t result;
+
+        flickerTrace(&analyzer, flickerCase.frequencyHz, flickerCase.depth);
+        analyzer.analyze(&result);
+
+        if (flickerCase.visible) {
+            const float window = PI * flickerCase.frequencyHz * FLICKER_SAMPLE_PERIOD_MS / 1000.0f;
+            const float expectedDepth = 1000 * flickerCase.depth * sinf(window) / window;
+
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(FLICKER_BIN_HZ / 2, flickerCase.frequencyHz, result.frequencyTenths / 10.0f,
+                                             flickerCase.name);
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.15f * expectedDepth, expectedDepth, result.depthPerMille, flickerCase.name);
+        } else {
+            TEST_ASSERT_EQUAL_UINT16_MESSAGE(0, result.frequencyTenths, flickerCase.name);
+        }
+    }
+}
+
+// Flicker mode on the sensor task, reported within the first sample buffers
+static void test_sensor_task() {
+    settings_t flickerSettings;
+    measurement_t measurement;
+    uint32_t nextUpdate = 0;
+
+    setup();
+    flickerSettings.mode = LIGHT_METER_MODE_FLICKER;
+    settingsSnapshot.write(flickerSettings);
+    simSetLux(400.0f);
+    simSetFlicker(6.0f, 0.5f);
+
+    const uint32_t start = millis();
+    measurementSnapshot.read(&measurement);
+    while (measurement.flicker.frequencyTenths == 0 && millis() - start < FLICKER_TEST_TIMEOUT_MS) {
+        if (millis() >= nextUpdate) {
+            nextUpdate = millis() + lightSensorUpdate();
+        }
+        simAdvanceMillis(1);
+        measurementSnapshot.read(&measurement);
+    }
+    simSetFlicker(0, 0);
+
+    TEST_ASSERT_FLOAT_WITHIN(FLICKER_BIN_HZ / 2, 6.0f, measurement.flicker.frequencyTenths / 10.0f);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_synthetic_traces);
+    RUN_TEST(test_sensor_task);
+    return UNITY_END();
+}
@@ -0,0 +1,78 @@
+/*
+  Renders every page over a spread of settings and fails if any frame
+  touched the heap
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "oled_display.h"
+#include "measurement.h"
+
+extern OledDisplay oledDisplay;
+extern settings_t settings;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_pages_render_without_heap() {
+    static const uint8_t pages[] = {OLED_PAGE_APERTURE, OLED_PAGE_SHUTTER, OLED_PAGE_ISO, OLED_PAGE_ND, OLED_PAGE_FLICKER,
+                                    OLED_PAGE_PRESETS, OLED_PAGE_MEMORY, OLED_PAGE_DIAGNOSTICS, OLED_PAGE_ERROR};
+    char message[32];
+
+    setup();
+
+    // Every slot stored, so the presets page draws all of them
+    for (uint8_t preset = 0; preset < CAMERA_PRESET_COUNT; preset++) {
+        settings.ndFilterIndex = preset;
+        cameraPresets.select(preset, &settings);
+        cameraPresets.store(settings);
+    }
+    presetsSnapshot.write(cameraPresets.get());
+
+    // Two stops apart, marked as key and fill
+    measurementMemory.push(850, 0);
+    measurementMemory.markFill();
+    measurementMemory.push(1050, 0);
+    measurementMemory.markKey();
+
+    for (uint8_t page : pages) {
+        uint32_t allocations = 0;
+
+        oledDisplay.setPage(page);
+
+        const stopSeries_t &isos = stopSeries(STOP_QUANTITY_ISO, settings.stopIncrement);
+
+        for (int8_t iso = isos.minIndex; iso <= isos.maxIndex; iso++) {
+            for (int8_t nd = ND_FILTER_INDEX_MIN; nd <= ND_FILTER_INDEX_MAX; nd++) {
+                settings.isoIndex = iso;
+                settings.ndFilterIndex = nd;
+                // Meter pages are in mode order after OLED_PAGE_NONE
+                settings.mode = (page <= OLED_PAGE_FLICKER) ? (lightMeterCompute_e)(page - OLED_PAGE_APERTURE)
+                                                            : LIGHT_METER_MODE_APERTURE;
+                settings.type = (lightMeterMode_e)(nd % LIGHT_METER_TYPE_COUNT);
+                settingsSnapshot.write(settings);
+                simSetLux(0.5f * stopEntry(STOP_QUANTITY_ISO, settings.stopIncrement, iso).value / 100 * (1 + nd));
+
+                lightSensorUpdate();
+
+                const uint32_t before = simGetHeapAllocations();
+                oledDisplay.loop();
+                allocations += simGetHeapAllocations() - before;
+            }
+        }
+
+        snprintf(message, sizeof(message), "page=%u", page);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocations, message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pages_render_without_heap);
+    return UNITY_END();
+}
@@ -0,0 +1,59 @@
+/*
+  I2C arbiter: handover between sensor and display on a private arbiter,
+  then the first frame after boot on the shared bus. It goes out whole,
+  yet no display transaction may be longer than one chunk
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "i2c_arbiter.h"
+#include "oled_display.h"
+
+extern OledDisplay oledDisplay;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// The sensor queues behind a display chunk and gets the bus with its release, then the other way round
+static void test_handover() {
+    I2cArbiter arbiter;
+
+    arbiter.begin(&Wire);
+
+    TEST_ASSERT_TRUE(arbiter.tryAcquire(I2C_CLIENT_DISPLAY));
+    TEST_ASSERT_FALSE(arbiter.tryAcquire(I2C_CLIENT_SENSOR));
+    arbiter.release(I2C_CLIENT_DISPLAY, 2 + OLED_FLUSH_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(I2C_CLIENT_SENSOR, arbiter.getOwner());
+    TEST_ASSERT_FALSE(arbiter.tryAcquire(I2C_CLIENT_DISPLAY));
+    arbiter.release(I2C_CLIENT_SENSOR, 5);
+    TEST_ASSERT_EQUAL(I2C_CLIENT_DISPLAY, arbiter.getOwner());
+    arbiter.release(I2C_CLIENT_DISPLAY, 2 + OLED_FLUSH_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(I2C_CLIENT_NONE, arbiter.getOwner());
+}
+
+static void test_first_frame_chunked() {
+    setup();
+    lightSensorUpdate();
+    oledDisplay.loop();
+
+    const i2cClientStats_t &display = i2cArbiter.getStats(I2C_CLIENT_DISPLAY);
+    const i2cClientStats_t &sensor = i2cArbiter.getStats(I2C_CLIENT_SENSOR);
+
+    TEST_ASSERT_GREATER_THAN(OLED_BUFFER_SIZE, display.bytes);
+    TEST_ASSERT_LESS_OR_EQUAL(2 + OLED_FLUSH_CHUNK_SIZE, display.maxTransactionBytes);
+    TEST_ASSERT_GREATER_THAN(0, sensor.transactions);
+    TEST_ASSERT_EQUAL(I2C_CLIENT_NONE, i2cArbiter.getOwner());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_handover);
+    RUN_TEST(test_first_frame_chunked);
+    return UNITY_END();
+}
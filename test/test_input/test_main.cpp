@@ -0,0 +1,87 @@
+/*
+  The UI loop against a blocking queue with measurements as sparse as in
+  flicker mode: buttons are pressed and held between two measurements,
+  every press has to come out once, as the right kind, and a long press
+  while the button is still held
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "input.h"
+
+#define INPUT_TEST_MS 10000
+// Flicker mode publishes a measurement once per sample buffer
+#define INPUT_TEST_MEASUREMENT_MS 1600
+
+typedef struct inputTestPress_s {
+    button_e button;
+    uint32_t startMs;
+    uint32_t durationMs;
+    inputPress_e expected;
+} inputTestPress_t;
+
+// Long presses are held across a measurement and end between two of them
+static const inputTestPress_t INPUT_TEST_PRESSES[] = {
+    {BUTTON_MODE, 500, 100, INPUT_PRESS_SHORT},
+    {BUTTON_UP, 2000, 1200, INPUT_PRESS_LONG},
+    {BUTTON_HOLD, 4900, 1500, INPUT_PRESS_LONG},
+    {BUTTON_LEFT, 7000, 20, INPUT_PRESS_NONE},
+    {BUTTON_RIGHT, 8100, 300, INPUT_PRESS_SHORT}
+};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_presses_between_sparse_measurements() {
+    static const uint8_t pins[BUTTON_COUNT] = {26, 13, 12, 14, 27, 0};
+    uint8_t reported[BUTTON_COUNT] = {};
+    uint32_t nextMeasurement = INPUT_TEST_MEASUREMENT_MS;
+
+    for (const inputTestPress_t &press : INPUT_TEST_PRESSES) {
+        simScheduleButtonPress(pins[press.button], press.startMs, press.durationMs);
+    }
+    inputBegin(pins);
+
+    while (millis() < INPUT_TEST_MS) {
+        inputEvent_t event;
+
+        simBlockQueuesUntil(nextMeasurement);
+        if (inputWaitEvent(&event) && event.type == INPUT_EVENT_BUTTON) {
+            const inputTestPress_t *press = nullptr;
+            for (const inputTestPress_t &candidate : INPUT_TEST_PRESSES) {
+                press = (candidate.button == event.button) ? &candidate : press;
+            }
+
+            TEST_ASSERT_NOT_NULL(press);
+            TEST_ASSERT_EQUAL_UINT8(0, reported[event.button]);
+            TEST_ASSERT_EQUAL(press->expected, event.press);
+            // Long presses are due INPUT_LONG_PRESS_MS in, the loop polls every INPUT_DEBOUNCE_MS
+            if (event.press == INPUT_PRESS_LONG) {
+                TEST_ASSERT_LESS_OR_EQUAL_UINT32(press->startMs + INPUT_LONG_PRESS_MS + INPUT_DEBOUNCE_MS, event.timestamp);
+            }
+            reported[event.button]++;
+        }
+        inputPoll();
+
+        if (millis() >= nextMeasurement) {
+            inputPostMeasurement();
+            nextMeasurement += INPUT_TEST_MEASUREMENT_MS;
+        }
+    }
+    simBlockQueuesUntil(0);
+
+    // Too short to count, the rest exactly once
+    for (const inputTestPress_t &press : INPUT_TEST_PRESSES) {
+        TEST_ASSERT_EQUAL_UINT8((press.expected != INPUT_PRESS_NONE) ? 1 : 0, reported[press.button]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_presses_between_sparse_measurements);
+    return UNITY_END();
+}
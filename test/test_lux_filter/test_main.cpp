@@ -0,0 +1,176 @@
+/*
+  Step, spike and noise response of every lux filter on synthetic traces,
+  fed log2(lux) in fixed point as the sensor task does
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "lux_filter.h"
+#include "exposure.h"
+
+#define FILTER_TRACE_LENGTH 64
+#define FILTER_STEP_FROM 100.0f
+// Half a stop, smoothed by every filter
+#define FILTER_STEP_SMALL 141.0f
+// Scene change, the EMA has to follow at once
+#define FILTER_STEP_LARGE 1000.0f
+
+typedef struct filterCase_s {
+    const char *name;
+    uint8_t type;
+    uint8_t samples;
+} filterCase_t;
+
+static const filterCase_t FILTER_CASES[] = {
+    {"none", LUX_FILTER_NONE, 1},
+    {"ema2", LUX_FILTER_EMA, 2},
+    {"ema8", LUX_FILTER_EMA, 8},
+    {"median5", LUX_FILTER_MEDIAN, 5},
+    {"median15", LUX_FILTER_MEDIAN, 15}
+};
+
+/*
+  Synthetic trace: 100 lux with +-10% deterministic noise, the kind of
+  jitter sampling a mains powered light at 4 Hz produces
+*/
+static float filterNoisyLux(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return FILTER_STEP_FROM * (0.9f + 0.2f * (*state >> 8) / (float)(1 << 24));
+}
+
+static float filterUpdate(LuxFilter *filter, float lux) {
+    return exp2f((float)filter->update(lroundf(log2f(lux) * EXPOSURE_FIXED_ONE)) / EXPOSURE_FIXED_ONE);
+}
+
+// Samples until the output stays within 10% of the step, in stops as the filter sees it
+static int filterSettleSamples(LuxFilter *filter, float to) {
+    int settled = -1;
+
+    filter->reset();
+    for (int i = 0; i < FILTER_TRACE_LENGTH; i++) {
+        const float lux = filterUpdate(filter, i == 0 ? FILTER_STEP_FROM : to);
+        if (i == 0) {
+            continue;
+        }
+        if (fabsf(log2f(lux / to)) > 0.1f * log2f(to / FILTER_STEP_FROM)) {
+            settled = -1;
+        } else if (settled < 0) {
+            settled = i;
+        }
+    }
+    return settled;
+}
+
+// Largest deviation from the baseline caused by a single sample spike
+static float filterSpikeResponse(LuxFilter *filter) {
+    float peak = 0;
+    float baseline = 0;
+
+    filter->reset();
+    for (int i = 0; i < FILTER_TRACE_LENGTH; i++) {
+        const float lux = filterUpdate(filter, i == FILTER_TRACE_LENGTH / 2 ? 100 * FILTER_STEP_FROM : FILTER_STEP_FROM);
+        // The steady output, FILTER_STEP_FROM after the round trip through fixed point
+        baseline = (i == 0) ? lux : baseline;
+        peak = fmaxf(peak, fabsf(lux - baseline));
+    }
+    return peak;
+}
+
+static float filterNoiseDeviation(LuxFilter *filter) {
+    uint32_t state = 1;
+    double sum = 0;
+    double sumSquares = 0;
+    // Skip the warm-up of the longest filter
+    const int skip = LUX_FILTER_WINDOW_MAX;
+
+    filter->reset();
+    for (int i = 0; i < FILTER_TRACE_LENGTH * 4; i++) {
+        const float lux = filterUpdate(filter, filterNoisyLux(&state));
+        if (i < skip) {
+            continue;
+        }
+        sum += lux;
+        sumSquares += (double)lux * lux;
+    }
+
+    const int count = FILTER_TRACE_LENGTH * 4 - skip;
+    const double mean = sum / count;
+    return sqrt(fmax(0.0, sumSquares / count - mean * mean));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// EMA needs ln(10) time constants to get within 10%, median half its window
+static void test_step_settles_within_lag() {
+    for (const filterCase_t &filterCase : FILTER_CASES) {
+        LuxFilter filter;
+        int expectedSettle = 1;
+
+        filter.configure(filterCase.type, filterCase.samples);
+        if (filterCase.type == LUX_FILTER_EMA) {
+            expectedSettle = (int)ceilf(logf(10.0f) * filterCase.samples);
+        } else if (filterCase.type == LUX_FILTER_MEDIAN) {
+            expectedSettle = filterCase.samples / 2 + 1;
+        }
+
+        const int settle = filterSettleSamples(&filter, FILTER_STEP_SMALL);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(0, settle, filterCase.name);
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(expectedSettle, settle, filterCase.name);
+    }
+}
+
+// A scene change goes through the EMA at once, the median still needs half its window
+static void test_scene_change_followed() {
+    for (const filterCase_t &filterCase : FILTER_CASES) {
+        LuxFilter filter;
+
+        filter.configure(filterCase.type, filterCase.samples);
+        const int expectedSettle = (filterCase.type == LUX_FILTER_MEDIAN) ? filterCase.samples / 2 + 1 : 1;
+
+        const int settle = filterSettleSamples(&filter, FILTER_STEP_LARGE);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(0, settle, filterCase.name);
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(expectedSettle, settle, filterCase.name);
+    }
+}
+
+static void test_median_rejects_spike() {
+    for (const filterCase_t &filterCase : FILTER_CASES) {
+        LuxFilter filter;
+
+        if (filterCase.type != LUX_FILTER_MEDIAN) {
+            continue;
+        }
+        filter.configure(filterCase.type, filterCase.samples);
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(0, filterSpikeResponse(&filter), filterCase.name);
+    }
+}
+
+static void test_filters_reduce_noise() {
+    LuxFilter raw;
+
+    raw.configure(LUX_FILTER_NONE, 1);
+    const float rawNoise = filterNoiseDeviation(&raw);
+
+    for (const filterCase_t &filterCase : FILTER_CASES) {
+        LuxFilter filter;
+
+        if (filterCase.type == LUX_FILTER_NONE) {
+            continue;
+        }
+        filter.configure(filterCase.type, filterCase.samples);
+        TEST_ASSERT_TRUE_MESSAGE(filterNoiseDeviation(&filter) < rawNoise, filterCase.name);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_step_settles_within_lag);
+    RUN_TEST(test_scene_change_followed);
+    RUN_TEST(test_median_rejects_spike);
+    RUN_TEST(test_filters_reduce_noise);
+    return UNITY_END();
+}
@@ -0,0 +1,84 @@
+/*
+  Logs a two minute session, dumps it over the simulated Serial with the
+  d command and decodes it back the way the decode tool does
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "native_log.h"
+#include "measurement_log.h"
+#include <vector>
+
+#define LOG_TEST_SECONDS 120
+#define LOG_DUMP_TIMEOUT_MS 60000
+
+extern MeasurementLog measurementLog;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_session_dump_decodes() {
+    std::vector<uint8_t> capture;
+    uint8_t buf[256];
+    uint32_t nextUpdate = 0;
+
+    setup();
+
+    // Slow drift with a few scene changes so deltas, counts and ranges vary
+    for (uint32_t t = 0; t < LOG_TEST_SECONDS * 1000; t++) {
+        if (t % 1000 == 0) {
+            simSetLux(50.0f * (1 + (t / 1000) % 7) * ((t / 20000) % 2 ? 40 : 1));
+        }
+        if (millis() >= nextUpdate) {
+            nextUpdate = millis() + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+    }
+
+    const uint32_t logged = measurementLog.getRecordCount();
+
+    simSerialCapture(true);
+    simSerialInject((const uint8_t *)"d\n", 2);
+
+    const uint32_t dumpStart = millis();
+    while (millis() - dumpStart < LOG_DUMP_TIMEOUT_MS) {
+        if (millis() >= nextUpdate) {
+            nextUpdate = millis() + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+
+        const size_t got = simSerialCaptured(buf, sizeof(buf));
+        capture.insert(capture.end(), buf, buf + got);
+        if (!measurementLog.isDumping() && capture.size() > 0) {
+            break;
+        }
+    }
+    simSerialCapture(false);
+
+    size_t offset;
+    size_t size;
+    TEST_ASSERT_TRUE(logPayload(capture, &offset, &size));
+    TEST_ASSERT_GREATER_THAN(0, offset);
+
+    FILE *csv = fopen("/dev/null", "w");
+    const uint32_t decoded = logWriteCsv(capture.data() + offset, size, csv);
+    fclose(csv);
+
+    // Samples logged after the dump started are not in it
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(logged, decoded);
+    TEST_ASSERT_EQUAL_UINT32(0, measurementLog.getDroppedRecords());
+    TEST_ASSERT_EQUAL_UINT32(0, simGetSerialBlockedBytes());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_session_dump_decodes);
+    return UNITY_END();
+}
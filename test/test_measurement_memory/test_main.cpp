@@ -0,0 +1,57 @@
+/*
+  Hold memory statistics: pseudo random readings through the memory,
+  after every push the kept mean, min and max have to match a scan over
+  the readings still stored
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "measurement_memory.h"
+
+#define MEMORY_TEST_PUSHES 1000
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_statistics_match_scan() {
+    MeasurementMemory memory;
+    uint32_t state = 1;
+
+    for (uint32_t i = 0; i < MEMORY_TEST_PUSHES; i++) {
+        state = state * 1664525 + 1013904223;
+        memory.push((int16_t)((state >> 16) % 2400) - 400, i);
+
+        // Key and fill move over the ring and fall out of it
+        if (i % 7 == 0) {
+            memory.moveCursor(-3);
+            memory.markKey();
+        } else if (i % 11 == 0) {
+            memory.markFill();
+        }
+
+        int32_t sum = 0;
+        int16_t min = INT16_MAX;
+        int16_t max = INT16_MIN;
+        for (uint8_t position = 0; position < memory.getCount(); position++) {
+            const int16_t ev = memory.get(position).evHundredths;
+            sum += ev;
+            min = (ev < min) ? ev : min;
+            max = (ev > max) ? ev : max;
+        }
+
+        TEST_ASSERT_INT_WITHIN(1, lroundf((float)sum / memory.getCount()), memory.getMean());
+        TEST_ASSERT_EQUAL_INT16(min, memory.getMin());
+        TEST_ASSERT_EQUAL_INT16(max, memory.getMax());
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(MEASUREMENT_MEMORY_CAPACITY, memory.getCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_statistics_match_scan);
+    return UNITY_END();
+}
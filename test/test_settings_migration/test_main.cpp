@@ -0,0 +1,61 @@
+/*
+  First boot after an update from firmware that saved its settings to
+  EEPROM: the old 16 byte layout has to come over into an empty journal,
+  full stop indices converted to thirds and the newer fields on their
+  defaults
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "types.h"
+
+// Layout of older firmware, the marker byte then the settings
+#define MIGRATION_EEPROM_SIZE 64
+#define MIGRATION_EEPROM_IDENT 0x69
+static const uint8_t MIGRATION_EEPROM_SETTINGS[] = {
+    2, 4, 7, 3,    // ISO 400, f/4, 1/125, ND 3 stops
+    1, 0, 0, 0,    // reflected
+    1, 0, 0, 0,    // shutter priority
+    2, 0, 0, 0     // adjusting the shutter
+};
+
+extern settings_t settings;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_eeprom_settings_taken_over() {
+    EEPROM.begin(MIGRATION_EEPROM_SIZE);
+    EEPROM.write(0, MIGRATION_EEPROM_IDENT);
+    for (uint8_t i = 0; i < sizeof(MIGRATION_EEPROM_SETTINGS); i++) {
+        EEPROM.write(1 + i, MIGRATION_EEPROM_SETTINGS[i]);
+    }
+
+    setup();
+
+    const settings_t defaults;
+
+    TEST_ASSERT_EQUAL_INT(6, settings.isoIndex);
+    TEST_ASSERT_EQUAL_INT(12, settings.apertureIndex);
+    TEST_ASSERT_EQUAL_INT(21, settings.shutterIndex);
+    TEST_ASSERT_EQUAL_INT(3, settings.ndFilterIndex);
+    TEST_ASSERT_EQUAL(LIGHT_METER_TYPE_REFLECTED, settings.type);
+    TEST_ASSERT_EQUAL(LIGHT_METER_MODE_SHUTTER, settings.mode);
+    TEST_ASSERT_EQUAL(ADJUST_SETTING_SHUTTER, settings.adjustSetting);
+    TEST_ASSERT_EQUAL_UINT8(defaults.luxFilter, settings.luxFilter);
+    TEST_ASSERT_EQUAL_UINT8(defaults.luxFilterSamples, settings.luxFilterSamples);
+    TEST_ASSERT_EQUAL_UINT8(STOP_INCREMENT_THIRD, settings.stopIncrement);
+    TEST_ASSERT_EQUAL_STRING("1/125", stopEntry(STOP_QUANTITY_SHUTTER, settings.stopIncrement, settings.shutterIndex).label);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_eeprom_settings_taken_over);
+    return UNITY_END();
+}
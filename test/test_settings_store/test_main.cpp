@@ -0,0 +1,95 @@
+/*
+  Settings journal on the simulated flash partition: button presses are
+  coalesced into one write, sectors are only erased when the journal
+  moves into them and the newest record comes back after a reboot
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "settings_store.h"
+
+// Shutter scrolled 14 thirds up and 8 back
+#define SCROLL_UP_PRESSES 14
+#define SCROLL_PRESSES 22
+#define SCROLL_INTERVAL_MS 150
+#define SCROLL_RUN_MS 12000
+
+#define JOURNAL_WRITES 1000
+
+// Every sector the journal moved into once, plus the one it started in
+#define JOURNAL_ERASE_BOUND(writes) ((writes) * SETTINGS_RECORD_SIZE / SETTINGS_STORE_SECTOR_SIZE + 1)
+
+extern SettingsStore settingsStore;
+extern settings_t settings;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/*
+  Fresh journal holding the defaults: the whole scroll is saved with one
+  write once it stopped and nothing goes through EEPROM
+*/
+static void test_scroll_coalesced() {
+    uint32_t nextSensorUpdate = 0;
+
+    // Down selects the shutter in aperture mode, then Right and Left
+    simScheduleButtonPress(12, 500, 100);
+    for (uint32_t i = 0; i < SCROLL_PRESSES; i++) {
+        simScheduleButtonPress((i < SCROLL_UP_PRESSES) ? 27 : 14, 800 + i * SCROLL_INTERVAL_MS, 80);
+    }
+
+    setup();
+
+    for (uint32_t t = millis(); t < SCROLL_RUN_MS; t = millis()) {
+        if (t >= nextSensorUpdate) {
+            nextSensorUpdate = t + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+    }
+
+    TEST_ASSERT_FALSE(settingsStore.isDirty());
+    TEST_ASSERT_EQUAL_UINT32(1, settingsStore.getWriteCount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(JOURNAL_ERASE_BOUND(settingsStore.getWriteCount()),
+                                     simGetFlashErases(SETTINGS_STORE_PARTITION));
+    TEST_ASSERT_EQUAL_UINT32(0, EEPROM.getCommitCount());
+}
+
+// A long run of saves wears every sector about the same, one erase per sector entered
+static void test_erases_bounded() {
+    SettingsStore store;
+    settings_t saved = settings;
+    const uint32_t erasesBefore = simGetFlashErases(SETTINGS_STORE_PARTITION);
+
+    TEST_ASSERT_TRUE(store.begin(&saved));
+
+    for (uint32_t i = 0; i < JOURNAL_WRITES; i++) {
+        saved.apertureIndex++;
+        store.update(saved);
+        store.flush();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(JOURNAL_WRITES, store.getWriteCount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(JOURNAL_ERASE_BOUND(JOURNAL_WRITES),
+                                     simGetFlashErases(SETTINGS_STORE_PARTITION) - erasesBefore);
+
+    // After a reboot the journal comes back with the last record
+    SettingsStore rebooted;
+    settings_t restored;
+
+    TEST_ASSERT_TRUE(rebooted.begin(&restored));
+    TEST_ASSERT_EQUAL_MEMORY(&saved, &restored, sizeof(settings_t));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scroll_coalesced);
+    RUN_TEST(test_erases_bounded);
+    return UNITY_END();
+}
@@ -0,0 +1,64 @@
+/*
+  Stop tables: two steps with the same label can't be told apart on
+  screen, every label has to be unique within its quantity and increment
+  and the exact values have to keep going up
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "stop_tables.h"
+
+static const char *const STOP_TEST_QUANTITY_NAMES[STOP_QUANTITY_COUNT] = {"shutter", "aperture", "iso"};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_labels_unique() {
+    char message[64];
+
+    for (uint8_t quantity = 0; quantity < STOP_QUANTITY_COUNT; quantity++) {
+        for (uint8_t increment = 0; increment < STOP_INCREMENT_COUNT; increment++) {
+            const stopSeries_t &series = stopSeries(quantity, increment);
+
+            for (int16_t i = series.minIndex; i <= series.maxIndex; i++) {
+                const char *label = stopEntry(quantity, increment, i).label;
+
+                for (int16_t j = series.minIndex; j < i; j++) {
+                    snprintf(message, sizeof(message), "%s 1/%u stop index %d label %s", STOP_TEST_QUANTITY_NAMES[quantity],
+                             STOP_STEPS_PER_STOP[increment], i, label);
+                    TEST_ASSERT_TRUE_MESSAGE(strcmp(label, stopEntry(quantity, increment, j).label) != 0, message);
+                }
+            }
+        }
+    }
+}
+
+// Shutter values are exposure times, they get shorter while the index goes up
+static void test_values_ordered() {
+    char message[64];
+
+    for (uint8_t quantity = 0; quantity < STOP_QUANTITY_COUNT; quantity++) {
+        for (uint8_t increment = 0; increment < STOP_INCREMENT_COUNT; increment++) {
+            const stopSeries_t &series = stopSeries(quantity, increment);
+
+            for (int16_t i = series.minIndex + 1; i <= series.maxIndex; i++) {
+                const float previous = stopEntry(quantity, increment, i - 1).value;
+                const float value = stopEntry(quantity, increment, i).value;
+
+                snprintf(message, sizeof(message), "%s 1/%u stop index %d", STOP_TEST_QUANTITY_NAMES[quantity],
+                         STOP_STEPS_PER_STOP[increment], i);
+                TEST_ASSERT_TRUE_MESSAGE((quantity == STOP_QUANTITY_SHUTTER) ? value < previous : value > previous, message);
+            }
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_labels_unique);
+    RUN_TEST(test_values_ordered);
+    return UNITY_END();
+}
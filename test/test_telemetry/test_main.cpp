@@ -0,0 +1,190 @@
+/*
+  Loopback of the telemetry stream: frames captured from the simulated
+  Serial are parsed back and compared with what was sent, at a sustainable
+  rate, under overload, with a corrupted byte and once turned on by the
+  t command
+*/
+
+#include <unity.h>
+#include "Arduino.h"
+#include "native_sim.h"
+#include "native_bench.h"
+#include "telemetry.h"
+
+#define TELEMETRY_TEST_MS 10000
+// 39 encoded bytes per frame, the sustained rate uses about 70% of the line
+#define TELEMETRY_TEST_SUSTAINED_HZ 200
+#define TELEMETRY_TEST_OVERLOAD_HZ 500
+#define TELEMETRY_TEST_COMMAND_MS 5000
+
+extern Telemetry telemetry;
+
+typedef struct telemetryRun_s {
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t parsed;
+    uint32_t crcErrors;
+    uint32_t lost;
+    uint32_t mismatched;
+} telemetryRun_t;
+
+static measurement_t telemetryTestMeasurement(uint32_t i) {
+    measurement_t measurement = {};
+
+    measurement.lux = 0.25f * i;
+    measurement.ev = -2.0f + 0.01f * i;
+    measurement.counts = i * 7;
+    measurement.gain = i % 4;
+    // Zero bytes on purpose, COBS has to carry them
+    measurement.integrationTime = 0;
+    measurement.outputValue = (int16_t)(i % 40) - 20;
+    measurement.settings.isoIndex = i % 9 - 2;
+    measurement.settings.shutterIndex = i % 64 - 18;
+    measurement.settings.stopIncrement = i % STOP_INCREMENT_COUNT;
+    measurement.flicker.frequencyTenths = i % 200;
+    measurement.flicker.depthPerMille = i % 1000;
+    return measurement;
+}
+
+static bool sameMeasurement(const measurement_t &a, const measurement_t &b) {
+    return a.lux == b.lux && a.ev == b.ev && a.counts == b.counts && a.gain == b.gain &&
+           a.integrationTime == b.integrationTime && a.outputValue == b.outputValue &&
+           a.settings.isoIndex == b.settings.isoIndex && a.settings.shutterIndex == b.settings.shutterIndex &&
+           a.settings.stopIncrement == b.settings.stopIncrement &&
+           a.flicker.frequencyTenths == b.flicker.frequencyTenths && a.flicker.depthPerMille == b.flicker.depthPerMille;
+}
+
+/*
+  Sends a frame every 1000 / hz ms of simulated time and parses the
+  captured bytes as they come out. corruptAt flips one byte of the stream
+*/
+static telemetryRun_t telemetryLoopback(uint32_t hz, uint32_t corruptAt) {
+    Telemetry sender;
+    TelemetryParser parser;
+    telemetryRun_t run = {};
+    uint8_t buf[256];
+    uint32_t streamBytes = 0;
+    uint32_t frame = 0;
+
+    simSerialCapture(true);
+
+    for (uint32_t t = 0; t < TELEMETRY_TEST_MS; t++) {
+        if (t * hz / 1000 != (t + 1) * hz / 1000) {
+            sender.send(telemetryTestMeasurement(frame), frame);
+            frame++;
+        }
+        simAdvanceMillis(1);
+
+        const size_t got = simSerialCaptured(buf, sizeof(buf));
+        for (size_t i = 0; i < got; i++, streamBytes++) {
+            if (streamBytes == corruptAt) {
+                buf[i] ^= 0x5A;
+            }
+            if (parser.feed(buf[i])) {
+                const telemetryMeasurement_t &decoded = parser.getMeasurement();
+                const measurement_t expected = telemetryTestMeasurement(decoded.frame);
+
+                if (decoded.sequence != decoded.frame || !sameMeasurement(decoded.measurement, expected)) {
+                    run.mismatched++;
+                }
+            }
+        }
+    }
+
+    simSerialCapture(false);
+
+    run.sent = sender.getSentFrames();
+    run.dropped = sender.getDroppedFrames();
+    run.parsed = parser.getFrames();
+    run.crcErrors = parser.getCrcErrors();
+    run.lost = parser.getLostFrames();
+    return run;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_sustained() {
+    const telemetryRun_t run = telemetryLoopback(TELEMETRY_TEST_SUSTAINED_HZ, UINT32_MAX);
+
+    TEST_ASSERT_EQUAL_UINT32(0, run.dropped);
+    TEST_ASSERT_EQUAL_UINT32(run.sent, run.parsed);
+    TEST_ASSERT_EQUAL_UINT32(0, run.crcErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, run.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, run.mismatched);
+    TEST_ASSERT_EQUAL_UINT32(0, simGetSerialBlockedBytes());
+}
+
+// Dropped frames show up as counter gaps on the receiver, nothing blocks
+static void test_overload() {
+    const telemetryRun_t run = telemetryLoopback(TELEMETRY_TEST_OVERLOAD_HZ, UINT32_MAX);
+
+    TEST_ASSERT_GREATER_THAN(0, run.dropped);
+    TEST_ASSERT_EQUAL_UINT32(run.dropped, run.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, run.crcErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, run.mismatched);
+    TEST_ASSERT_EQUAL_UINT32(0, simGetSerialBlockedBytes());
+}
+
+// One bad frame, the parser picks up again at the next delimiter
+static void test_corrupted() {
+    const telemetryRun_t run = telemetryLoopback(TELEMETRY_TEST_SUSTAINED_HZ, 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(1, run.crcErrors);
+    TEST_ASSERT_EQUAL_UINT32(1, run.lost);
+    TEST_ASSERT_EQUAL_UINT32(run.sent - 1, run.parsed);
+    TEST_ASSERT_EQUAL_UINT32(0, run.mismatched);
+}
+
+// "t4" over Serial turns on the stream of real sensor snapshots
+static void test_command() {
+    TelemetryParser parser;
+    uint8_t buf[256];
+    uint32_t nextUpdate = 0;
+    uint32_t matched = 0;
+
+    simSetLux(300.0f);
+    simSerialCapture(true);
+    simSerialInject((const uint8_t *)"t4\n", 3);
+
+    for (uint32_t t = 0; t < TELEMETRY_TEST_COMMAND_MS; t++) {
+        if (millis() >= nextUpdate) {
+            nextUpdate = millis() + lightSensorUpdate();
+        }
+        loop();
+        simAdvanceMillis(1);
+
+        const size_t got = simSerialCaptured(buf, sizeof(buf));
+        for (size_t i = 0; i < got; i++) {
+            if (parser.feed(buf[i])) {
+                measurement_t latest;
+                measurementSnapshot.read(&latest);
+                matched += parser.getMeasurement().measurement.ev == latest.ev;
+            }
+        }
+    }
+
+    simSerialCapture(false);
+
+    // The sensor publishes at 4Hz, a frame per snapshot
+    TEST_ASSERT_EQUAL_UINT32(4, telemetry.getRate());
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(18, parser.getFrames());
+    TEST_ASSERT_EQUAL_UINT32(parser.getFrames(), matched);
+    TEST_ASSERT_EQUAL_UINT32(0, parser.getCrcErrors());
+    TEST_ASSERT_EQUAL_UINT32(0, parser.getLostFrames());
+}
+
+int main() {
+    // Sets up the TX buffer the stream relies on
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_sustained);
+    RUN_TEST(test_overload);
+    RUN_TEST(test_corrupted);
+    RUN_TEST(test_command);
+    return UNITY_END();
+}